@@ -10,7 +10,7 @@ INCLUDEPATH += .
 QT += widgets
 
 # Input
-HEADERS += diagramwindow.h link.h node.h propertiesdialog.h
+HEADERS += diagramwindow.h link.h node.h propertiesdialog.h smallvector.h
 FORMS += propertiesdialog.ui
 SOURCES += diagramwindow.cpp link.cpp main.cpp node.cpp propertiesdialog.cpp
 RESOURCES += resources.qrc
@@ -18,6 +18,9 @@ class DiagramWindow : public QMainWindow
 public:
     DiagramWindow();
 
+protected:
+    void changeEvent(QEvent *event);
+
 private slots:
     void addNode();
     void addLink();
@@ -1,13 +1,25 @@
 #include <QtWidgets>
 #include <utility>
+#include <vector>
 
 #include "link.h"
 #include "node.h"
 
+namespace {
+const qreal ARROW_WIDTH = 10;
+const qreal ARROW_LENGTH = 12;
+// Room for the selected pen, which is wider than pen().
+const qreal SELECTED_MARGIN = 1;
+
+// Links waiting for trackPendingLinks().
+std::vector<Link *> pendingLinks;
+}
+
 Link::Link(Node *fromNode, Node *toNode)
 {
     myFromNode = fromNode;
     myToNode = toNode;
+    myPendingIndex = -1;
 
     myFromNode->addLink(this);
     myToNode->addLink(this);
@@ -21,6 +33,12 @@ Link::Link(Node *fromNode, Node *toNode)
 
 Link::~Link()
 {
+    if (myPendingIndex >= 0) {
+        Link *last = pendingLinks.back();
+        pendingLinks[myPendingIndex] = last;
+        last->myPendingIndex = myPendingIndex;
+        pendingLinks.pop_back();
+    }
     myFromNode->removeLink(this);
     myToNode->removeLink(this);
 }
@@ -45,63 +63,72 @@ QColor Link::color() const
     return pen().color();
 }
 
+// The arrowhead sits at the midpoint of the link and points towards
+// toNode. It is computed here, from the unit direction of the link, so
+// that paint() and the geometry functions only read it.
 void Link::trackNodes()
 {
-    setLine(QLineF(myFromNode->pos(), myToNode->pos()));
+    QPointF p1 = myFromNode->pos();
+    QPointF p2 = myToNode->pos();
+
+    prepareGeometryChange();
+    myArrow.clear();
+    QLineF segment(p1, p2);
+    qreal length = segment.length();
+    if (length > 0) {
+        QPointF direction = (p2 - p1) / length;
+        QPointF normal(-direction.y(), direction.x());
+        QPointF middle = (p1 + p2) / 2;
+        myArrow << middle + ARROW_LENGTH * direction
+                << middle + ARROW_WIDTH / 2 * normal
+                << middle - ARROW_WIDTH / 2 * normal;
+    }
+    setLine(segment);
 }
 
-void Link::turnRound()
+// Defers trackNodes() to the next trackPendingLinks(). A link whose nodes
+// move many times in between, or which is marked by both of its nodes, is
+// updated once. Node::mouseMoveEvent() flushes at the end of each drag
+// step; the timer covers moves made in code.
+void Link::trackLater()
 {
-    std::swap(myFromNode, myToNode);
+    if (myPendingIndex >= 0)
+        return;
+
+    if (pendingLinks.empty())
+        QTimer::singleShot(0, &Link::trackPendingLinks);
+    myPendingIndex = pendingLinks.size();
+    pendingLinks.push_back(this);
 }
 
-namespace {
-void drawArrowLine(QPainter &painter, const QPointF &p1, const QPointF &p2) // from p1 to p2
+void Link::trackPendingLinks()
 {
-    painter.drawLine(p1, p2);
-    if (p1 == p2)
-        return;
-
-    QPointF pm((p1.x()+p2.x())/2, (p1.y()+p2.y())/2); // p1p2е
-    int width = 10;     // ͷ
-    int length = 12;    // ͷ
-    QPointF pa, pb, pc;  // paΪͷ, pb, pcΪߵĶ
-    double sin1, cos1, sin2, cos2;
-    if (p1.x() == p2.x()) {         // ֱֱ
-        cos1 = 0;
-        sin1 = p1.y() < p2.y() ? 1 : -1;
-        cos2 = 1;
-        sin2 = 0;
-    } else if (p1.y() == p2.y()) {  // ˮƽֱ
-        cos1 = p1.x() < p2.x() ? 1 : -1;
-        sin1 = 0;
-        cos2 = 0;
-        sin2 = 1;
-    } else {                        // бֱ
-        // ֱб
-        double k1 = ((double) (p2.y() - p1.y())) / ((double) (p2.x() - p1.x()));
-        double k2 = -1 / k1;    // б
-
-        // k = tan, cos = +-sqrt(1/(1+k*k)), sin = +-sqrt(k*k/(1+k*k));
-        cos1 = (p1.x() < p2.x() ? 1 : -1) * sqrt(1 / (1 + k1*k1));
-        sin1 = (p1.y() < p2.y() ? 1 : -1) * sqrt((k1 * k1) / (1 + k1*k1));
-        cos2 = sqrt(1 / (1 + k2*k2));
-        sin2 = (k2 > 0 ? 1 : -1) * sqrt((k2 * k2) / (1 + k2*k2));
+    std::vector<Link *> links;
+    links.swap(pendingLinks);
+    for (Link *link: links) {
+        link->myPendingIndex = -1;
+        link->trackNodes();
     }
+}
+
+QRectF Link::boundingRect() const
+{
+    return (QGraphicsLineItem::boundingRect() | myArrow.boundingRect())
+           .adjusted(-SELECTED_MARGIN, -SELECTED_MARGIN,
+                     SELECTED_MARGIN, SELECTED_MARGIN);
+}
 
-    pa.setX(cos1*length+pm.x());
-    pa.setY(sin1*length+pm.y());
-    pb.setX(cos2*width/2+pm.x());
-    pb.setY(sin2*width/2+pm.y());   // (pb.y - pm.y) / (width/2) = sin2
-    pc.setX(-cos2*width/2+pm.x());
-    pc.setY(-sin2*width/2+pm.y());  // (pm.y - pc.y) / (width/2) = sin2
-
-    QPointF points[3];
-    points[0] = pa;
-    points[1] = pb;
-    points[2] = pc;
-    painter.drawPolygon(points, 3);
+QPainterPath Link::shape() const
+{
+    QPainterPath path = QGraphicsLineItem::shape();
+    path.addPolygon(myArrow);
+    path.closeSubpath();
+    return path;
 }
+
+void Link::turnRound()
+{
+    std::swap(myFromNode, myToNode);
 }
 
 void Link::paint(QPainter *painter,
@@ -116,5 +143,17 @@ void Link::paint(QPainter *painter,
     painter->setPen(pen);
     painter->setBrush(color());
 
-    drawArrowLine(*painter, myFromNode->pos(), myToNode->pos());
+    // Arrowheads are dropped along with node outlines.
+    Node::Detail detail = Node::detailFor(option->levelOfDetailFromTransform(
+                                              painter->worldTransform()));
+    if (detail < Node::OutlineDetail) {
+        if (detail == Node::PointDetail)
+            painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->drawLine(line());
+        return;
+    }
+
+    painter->drawLine(line());
+    if (!myArrow.isEmpty())
+        painter->drawPolygon(myArrow);
 }
@@ -2,6 +2,7 @@
 #define LINK_H
 
 #include <QGraphicsLineItem>
+#include <QPolygonF>
 
 class Node;
 
@@ -18,7 +19,11 @@ public:
     QColor color() const;
 
     void trackNodes();
+    void trackLater();
+    static void trackPendingLinks();
 
+    QRectF boundingRect() const;
+    QPainterPath shape() const;
     void paint(QPainter *painter,
                const QStyleOptionGraphicsItem *option, QWidget *widget);
 
@@ -27,6 +32,8 @@ public:
 private:
     Node *myFromNode;
     Node *myToNode;
+    int myPendingIndex;
+    QPolygonF myArrow;
 };
 
 #endif
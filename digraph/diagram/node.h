@@ -4,7 +4,8 @@
 #include <QApplication>
 #include <QColor>
 #include <QGraphicsItem>
-#include <QSet>
+#include <QPainterPath>
+#include "smallvector.h"
 
 class Link;
 
@@ -13,6 +14,10 @@ class Node : public QGraphicsItem
     Q_DECLARE_TR_FUNCTIONS(Node)
 
 public:
+    // How much of a node is drawn at a given view scale; see
+    // setDetailThresholds().
+    enum Detail { PointDetail, RectDetail, OutlineDetail, FullDetail };
+
     Node();
     ~Node();
 
@@ -24,6 +29,7 @@ public:
     QColor outlineColor() const;
     void setBackgroundColor(const QColor &color);
     QColor backgroundColor() const;
+    void fontChanged();
 
     void addLink(Link *link);
     void removeLink(Link *link);
@@ -33,20 +39,30 @@ public:
     void paint(QPainter *painter,
                const QStyleOptionGraphicsItem *option, QWidget *widget);
 
+    static void setDetailThresholds(qreal textLevel, qreal outlineLevel,
+                                    qreal rectLevel);
+    static Detail detailFor(qreal levelOfDetail);
+    static void setPixmapCaching(bool enabled);
+    static void setPixmapCacheBudget(int kilobytes);
+
 protected:
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event);
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
     QVariant itemChange(GraphicsItemChange change,
                         const QVariant &value);
 
 private:
     QRectF outlineRect() const;
+    void updateOutline();
     int roundness(double size) const;
 
-    QSet<Link *> myLinks;
+    SmallVector<Link *, 4> myLinks;
     QString myText;
     QColor myTextColor;
     QColor myBackgroundColor;
     QColor myOutlineColor;
+    QRectF myOutlineRect;
+    QPainterPath myShape;
 };
 
 #endif
@@ -0,0 +1,11 @@
+# Memory and speed of a node's link list at 1M nodes: the SmallVector that
+# Node keeps, against the QSet it used before and a plain QList.
+
+TEMPLATE = app
+TARGET = adjacency
+QT = core
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
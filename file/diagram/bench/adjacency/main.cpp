@@ -0,0 +1,145 @@
+#include <QElapsedTimer>
+#include <QList>
+#include <QSet>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "smallvector.h"
+
+namespace {
+const int NODE_COUNT = 1000000;
+const int LINK_COUNT = 2000000;
+// Every HUB_EVERY-th link ends at one of a few hub nodes.
+const int HUB_EVERY = 50;
+const int HUB_COUNT = 100;
+
+struct Link
+{
+    int from;
+    int to;
+};
+
+// The three ways a node can keep its links, each with the operations Node
+// performs: addLink(), removeLink() and a walk over the links whenever the
+// node moves.
+struct SmallVectorLinks
+{
+    static const char *name() { return "SmallVector"; }
+    void add(Link *link)
+    {
+        if (links.isEmpty() || links.last() != link)
+            links.append(link);
+    }
+    void remove(Link *link) { links.removeOne(link); }
+    SmallVector<Link *, 4> links;
+};
+
+struct SetLinks
+{
+    static const char *name() { return "QSet"; }
+    void add(Link *link) { links.insert(link); }
+    void remove(Link *link) { links.remove(link); }
+    QSet<Link *> links;
+};
+
+struct ListLinks
+{
+    static const char *name() { return "QList"; }
+    void add(Link *link)
+    {
+        if (links.isEmpty() || links.last() != link)
+            links.append(link);
+    }
+    void remove(Link *link) { links.removeOne(link); }
+    QList<Link *> links;
+};
+
+// Bytes in use on the heap, or zero where that cannot be told.
+size_t heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+double millisecondsSince(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+std::vector<Link> makeLinks()
+{
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> node(0, NODE_COUNT - 1);
+    std::uniform_int_distribution<int> hub(0, HUB_COUNT - 1);
+    std::vector<Link> links(LINK_COUNT);
+    for (int i = 0; i < LINK_COUNT; ++i) {
+        links[i].from = node(random);
+        links[i].to = i % HUB_EVERY ? node(random) : hub(random);
+    }
+    return links;
+}
+
+// Adds every link to both of its nodes, walks the links of every node,
+// then removes the links in random order.
+template <typename Links>
+void run(std::vector<Link> &links, const std::vector<int> &removeOrder)
+{
+    QElapsedTimer timer;
+    size_t heapBefore = heapInUse();
+    timer.start();
+    std::vector<Links> nodes(NODE_COUNT);
+    for (Link &link: links) {
+        nodes[link.from].add(&link);
+        nodes[link.to].add(&link);
+    }
+    double add = millisecondsSince(timer);
+    double bytes = double(heapInUse() - heapBefore) / NODE_COUNT;
+
+    long long checksum = 0;
+    timer.restart();
+    for (const Links &node: nodes) {
+        for (Link *link: node.links)
+            checksum += link->to;
+    }
+    double walk = millisecondsSince(timer);
+
+    timer.restart();
+    for (int i: removeOrder) {
+        nodes[links[i].from].remove(&links[i]);
+        nodes[links[i].to].remove(&links[i]);
+    }
+    double remove = millisecondsSince(timer);
+
+    std::printf("%-12s %10.1f %10.1f %10.1f %10.1f %14lld\n", Links::name(),
+                bytes, add, walk, remove, checksum);
+}
+}
+
+int main()
+{
+    std::vector<Link> links = makeLinks();
+    std::vector<int> removeOrder(LINK_COUNT);
+    for (int i = 0; i < LINK_COUNT; ++i)
+        removeOrder[i] = i;
+    std::shuffle(removeOrder.begin(), removeOrder.end(), std::mt19937(2));
+
+    std::printf("%d nodes, %d links, every %dth to one of %d hubs\n",
+                NODE_COUNT, LINK_COUNT, HUB_EVERY, HUB_COUNT);
+    std::printf("bytes are per node, including the node's slot; times in "
+                "ms\n\n");
+    std::printf("%-12s %10s %10s %10s %10s %14s\n", "links", "bytes", "add",
+                "walk", "remove", "checksum");
+    run<SmallVectorLinks>(links, removeOrder);
+    run<SetLinks>(links, removeOrder);
+    run<ListLinks>(links, removeOrder);
+    return 0;
+}
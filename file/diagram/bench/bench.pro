@@ -0,0 +1,6 @@
+# Benchmarks of the diagram's building blocks. Each one is an executable that
+# prints its timings; build them in release mode.
+
+TEMPLATE = subdirs
+SUBDIRS += adjacency json11document json11numbers json11objects json11scan \
+           noderendering sceneindex
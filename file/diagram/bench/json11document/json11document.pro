@@ -0,0 +1,11 @@
+# Parse times of Json::parse against JsonDocument's arena, for journal
+# lines read one at a time as DiagramJournal::replay() reads them, and for
+# one large document.
+
+TEMPLATE = app
+TARGET = json11document
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp ../../json11.cpp
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "json11.hpp"
+
+using json11::Json;
+using json11::JsonDocument;
+
+namespace {
+const int LINE_COUNT = 1000000;
+const int NODE_COUNT = 1000000;
+const int RUNS = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+           .count();
+}
+
+// Journal lines as DiagramJournal writes them: moves, with a rename and an
+// addition now and then.
+std::vector<std::string> makeJournal()
+{
+    std::vector<std::string> lines;
+    lines.reserve(LINE_COUNT);
+    for (int i = 0; i < LINE_COUNT; ++i) {
+        std::string index = std::to_string(i % 5000);
+        if (i % 10 == 0)
+            lines.push_back("{\"index\": " + index + ", \"op\": \"renameNode\", "
+                            "\"text\": \"Renamed node " + index + "\"}\n");
+        else if (i % 10 == 1)
+            lines.push_back("{\"backgroundColor\": \"#ffffffff\", \"index\": "
+                            + index + ", \"op\": \"addNode\", \"outlineColor\": "
+                            "\"#ff00008b\", \"text\": \"Node\", \"textColor\": "
+                            "\"#ff006400\", \"x\": 10, \"y\": 20}\n");
+        else
+            lines.push_back("{\"index\": " + index + ", \"op\": \"moveNode\", "
+                            "\"x\": " + std::to_string(i % 997) + ", \"y\": "
+                            + std::to_string(i % 991) + "}\n");
+    }
+    return lines;
+}
+
+std::string makeDocument()
+{
+    std::string text = "{\"links\": [], \"nodes\": [";
+    for (int i = 0; i < NODE_COUNT; ++i) {
+        text += i ? ", " : "";
+        text += "{\"index\": " + std::to_string(i) + ", \"text\": \"Node "
+                + std::to_string(i) + "\", \"x\": " + std::to_string(i % 1000)
+                + ", \"y\": " + std::to_string(i / 1000) + "}";
+    }
+    text += "]}";
+    return text;
+}
+
+// What replay() reads from a line.
+long long readLine(const Json &json)
+{
+    return json["op"].string_value().size() + json["index"].int_value()
+           + json["x"].int_value() + json["text"].string_value().size();
+}
+
+void check(const std::string &err)
+{
+    if (!err.empty()) {
+        std::printf("parse error: %s\n", err.c_str());
+        std::exit(1);
+    }
+}
+
+// Best times over RUNS of each way to parse the journal, line by line.
+void journal(const std::vector<std::string> &lines)
+{
+    double heap = 1e300, fresh = 1e300, reused = 1e300;
+    long long checksums[3] = { 0, 0, 0 };
+    for (int run = 0; run < RUNS; ++run) {
+        std::string err;
+        long long checksum = 0;
+        Clock::time_point start = Clock::now();
+        for (const auto &line: lines) {
+            checksum += readLine(Json::parse(line.data(), line.size(), err));
+            check(err);
+        }
+        heap = std::min(heap, millisecondsSince(start));
+        checksums[0] = checksum;
+
+        checksum = 0;
+        start = Clock::now();
+        for (const auto &line: lines) {
+            JsonDocument document;
+            document.parse(line.data(), line.size(), err);
+            check(err);
+            checksum += readLine(document.root());
+        }
+        fresh = std::min(fresh, millisecondsSince(start));
+        checksums[1] = checksum;
+
+        checksum = 0;
+        start = Clock::now();
+        JsonDocument document;
+        for (const auto &line: lines) {
+            document.parse(line.data(), line.size(), err);
+            check(err);
+            checksum += readLine(document.root());
+        }
+        reused = std::min(reused, millisecondsSince(start));
+        checksums[2] = checksum;
+    }
+    if (checksums[0] != checksums[1] || checksums[0] != checksums[2]) {
+        std::printf("journal checksums disagree\n");
+        std::exit(1);
+    }
+    std::printf("%d journal lines: Json::parse %.1f, a JsonDocument per line "
+                "%.1f, one JsonDocument reused %.1f\n", LINE_COUNT, heap,
+                fresh, reused);
+}
+
+void document(const std::string &text)
+{
+    double heap = 1e300, arena = 1e300;
+    for (int run = 0; run < RUNS; ++run) {
+        std::string err;
+        Clock::time_point start = Clock::now();
+        {
+            Json json = Json::parse(text, err);
+            check(err);
+        }
+        heap = std::min(heap, millisecondsSince(start));
+
+        start = Clock::now();
+        {
+            JsonDocument document;
+            document.parse(text.data(), text.size(), err);
+            check(err);
+        }
+        arena = std::min(arena, millisecondsSince(start));
+    }
+    std::printf("a document of %d nodes, parsed and freed: Json::parse %.1f, "
+                "JsonDocument %.1f\n", NODE_COUNT, heap, arena);
+}
+}
+
+int main()
+{
+    std::printf("times in ms, best of %d runs\n\n", RUNS);
+    journal(makeJournal());
+    document(makeDocument());
+    return 0;
+}
@@ -0,0 +1,9 @@
+// json11 as the diagram builds it: numbers go through std::from_chars and
+// std::to_chars.
+#include "../../json11.cpp"
+#include "numberrun.h"
+
+NumberTimes benchmarkCharconv(const std::string &text)
+{
+    return runBenchmark(text);
+}
@@ -0,0 +1,13 @@
+# Parse and dump times of json11 numbers with std::from_chars/to_chars, as
+# the diagram builds json11, against the snprintf/strtod path it used
+# before. charconv.cpp and stdio.cpp each compile json11.cpp into a
+# namespace of its own.
+
+TEMPLATE = app
+TARGET = json11numbers
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+HEADERS += numberbench.h numberrun.h
+SOURCES += main.cpp charconv.cpp stdio.cpp
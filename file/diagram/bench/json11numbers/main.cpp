@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include "numberbench.h"
+
+namespace {
+const int NUMBER_COUNT = 2000000;
+
+// Node coordinates and indexes, as a .diag file holds them.
+std::string makeIntegers()
+{
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> coordinate(-100000, 100000);
+    std::string text = "[";
+    for (int i = 0; i < NUMBER_COUNT; ++i) {
+        text += i ? ", " : "";
+        text += std::to_string(i % 3 ? coordinate(random) : i);
+    }
+    text += "]";
+    return text;
+}
+
+// Fractional coordinates, written with all the digits a double needs.
+std::string makeDoubles()
+{
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> coordinate(-100000, 100000);
+    std::string text = "[";
+    char buf[32];
+    for (int i = 0; i < NUMBER_COUNT; ++i) {
+        std::snprintf(buf, sizeof buf, "%.17g", coordinate(random));
+        text += i ? ", " : "";
+        text += buf;
+    }
+    text += "]";
+    return text;
+}
+}
+
+int main()
+{
+    std::printf("%d numbers per document, times in ms\n\n", NUMBER_COUNT);
+    std::printf("%-9s %13s %13s %13s %13s %13s %13s\n", "numbers",
+                "parse chars", "parse stdio", "dump chars", "dump stdio",
+                "bytes chars", "bytes stdio");
+
+    const char *const NAMES[] = { "integers", "doubles" };
+    for (int kind = 0; kind < 2; ++kind) {
+        std::string text = kind ? makeDoubles() : makeIntegers();
+        NumberTimes chars = benchmarkCharconv(text);
+        NumberTimes stdio = benchmarkStdio(text);
+        if (chars.checksum != stdio.checksum) {
+            std::printf("parsed %s disagree\n", NAMES[kind]);
+            return 1;
+        }
+        std::printf("%-9s %13.1f %13.1f %13.1f %13.1f %13zu %13zu\n",
+                    NAMES[kind], chars.parse, stdio.parse, chars.dump,
+                    stdio.dump, chars.size, stdio.size);
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef NUMBERBENCH_H
+#define NUMBERBENCH_H
+
+#include <string>
+
+// Best times of several runs, in milliseconds, over a document that is an
+// array of numbers. The checksum is the sum of the parsed numbers, which
+// has to agree between the two builds; size is the length of the dumped
+// text.
+struct NumberTimes
+{
+    double parse;
+    double dump;
+    double checksum;
+    size_t size;
+};
+
+NumberTimes benchmarkCharconv(const std::string &text);
+NumberTimes benchmarkStdio(const std::string &text);
+
+#endif
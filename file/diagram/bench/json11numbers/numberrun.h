@@ -0,0 +1,55 @@
+#ifndef NUMBERRUN_H
+#define NUMBERRUN_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "numberbench.h"
+
+// The body of both benchmarks. charconv.cpp and stdio.cpp include it after
+// their own build of json11.cpp, so that json11 here names the parser
+// under test.
+namespace {
+const int RUNS = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+           .count();
+}
+
+NumberTimes runBenchmark(const std::string &text)
+{
+    NumberTimes best = { 1e300, 1e300, 0, 0 };
+    for (int run = 0; run < RUNS; ++run) {
+        std::string err;
+        Clock::time_point start = Clock::now();
+        json11::Json document = json11::Json::parse(text, err);
+        double parse = millisecondsSince(start);
+        if (!err.empty()) {
+            std::cerr << "parse error: " << err << '\n';
+            std::exit(1);
+        }
+
+        std::string out;
+        start = Clock::now();
+        document.dump(out);
+        double dump = millisecondsSince(start);
+
+        double checksum = 0;
+        for (const auto &item: document.array_items())
+            checksum += item.number_value();
+
+        best.parse = std::min(best.parse, parse);
+        best.dump = std::min(best.dump, dump);
+        best.checksum = checksum;
+        best.size = out.size();
+    }
+    return best;
+}
+}
+
+#endif
@@ -0,0 +1,12 @@
+// json11 with numbers written by snprintf and read by atoi/strtod, renamed
+// so that it can be linked next to the build in charconv.cpp.
+#define JSON11_NO_CHARCONV
+#define json11 json11_stdio
+#include "../../json11.cpp"
+#include "numberrun.h"
+#undef json11
+
+NumberTimes benchmarkStdio(const std::string &text)
+{
+    return runBenchmark(text);
+}
@@ -0,0 +1,10 @@
+// json11 as the diagram builds it: objects of up to eight members are
+// stored flat.
+#include "../../json11.cpp"
+#include "objectrun.h"
+
+ObjectTimes benchmarkFlat(const std::string &text,
+                          const std::vector<std::string> &keys)
+{
+    return runBenchmark(text, keys);
+}
@@ -0,0 +1,12 @@
+# Parse and lookup times of json11 objects stored flat, as the diagram
+# builds json11, against the same parser keeping every object in a std::map.
+# flat.cpp and map.cpp each compile json11.cpp into a namespace of its own.
+
+TEMPLATE = app
+TARGET = json11objects
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+HEADERS += objectbench.h objectrun.h
+SOURCES += main.cpp flat.cpp map.cpp
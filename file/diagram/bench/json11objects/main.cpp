@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "objectbench.h"
+
+namespace {
+const int OBJECT_COUNT = 200000;
+const int MEMBER_COUNTS[] = { 2, 4, 8, 16 };
+
+// Member names of the length of the diagram's own ("index", "text", ...).
+std::string memberName(int i)
+{
+    static const char *const NAMES[] = { "index", "text", "x", "y", "from",
+                                         "to", "color", "width" };
+    std::string name = NAMES[i % 8];
+    if (i >= 8)
+        name += std::to_string(i / 8);
+    return name;
+}
+
+std::string makeDocument(int members)
+{
+    std::string text = "[";
+    for (int i = 0; i < OBJECT_COUNT; ++i) {
+        text += i ? ", {" : "{";
+        for (int m = 0; m < members; ++m) {
+            if (m)
+                text += ", ";
+            text += '"' + memberName(m) + "\": " + std::to_string(i + m);
+        }
+        text += '}';
+    }
+    text += "]";
+    return text;
+}
+}
+
+// Each object is looked up by all of its members and one it does not have.
+int main()
+{
+    std::printf("%d objects per document, times in ms\n\n", OBJECT_COUNT);
+    std::printf("%8s %12s %12s %12s %12s\n", "members", "parse flat",
+                "parse map", "lookup flat", "lookup map");
+
+    for (int members: MEMBER_COUNTS) {
+        std::string text = makeDocument(members);
+        std::vector<std::string> keys;
+        for (int m = 0; m < members; ++m)
+            keys.push_back(memberName(m));
+        keys.push_back("missing");
+
+        ObjectTimes flat = benchmarkFlat(text, keys);
+        ObjectTimes map = benchmarkMap(text, keys);
+        if (flat.checksum != map.checksum) {
+            std::printf("lookups disagree for %d members\n", members);
+            return 1;
+        }
+        std::printf("%8d %12.1f %12.1f %12.1f %12.1f\n", members, flat.parse,
+                    map.parse, flat.lookup, map.lookup);
+    }
+    return 0;
+}
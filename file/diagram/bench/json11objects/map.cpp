@@ -0,0 +1,13 @@
+// json11 with every non-empty object in a std::map, renamed so that it can
+// be linked next to the build in flat.cpp.
+#define JSON11_SMALL_OBJECT_SIZE 0
+#define json11 json11_map
+#include "../../json11.cpp"
+#include "objectrun.h"
+#undef json11
+
+ObjectTimes benchmarkMap(const std::string &text,
+                         const std::vector<std::string> &keys)
+{
+    return runBenchmark(text, keys);
+}
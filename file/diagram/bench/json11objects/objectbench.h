@@ -0,0 +1,22 @@
+#ifndef OBJECTBENCH_H
+#define OBJECTBENCH_H
+
+#include <string>
+#include <vector>
+
+// Best times of several runs, in milliseconds, over a document that is an
+// array of objects. The checksum is the sum of all values looked up, which
+// has to agree between the two builds.
+struct ObjectTimes
+{
+    double parse;
+    double lookup;
+    long long checksum;
+};
+
+ObjectTimes benchmarkFlat(const std::string &text,
+                          const std::vector<std::string> &keys);
+ObjectTimes benchmarkMap(const std::string &text,
+                         const std::vector<std::string> &keys);
+
+#endif
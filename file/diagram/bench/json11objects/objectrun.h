@@ -0,0 +1,53 @@
+#ifndef OBJECTRUN_H
+#define OBJECTRUN_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "objectbench.h"
+
+// The body of both benchmarks. flat.cpp and map.cpp include it after their
+// own build of json11.cpp, so that json11 here names the parser under test.
+namespace {
+const int RUNS = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+           .count();
+}
+
+ObjectTimes runBenchmark(const std::string &text,
+                         const std::vector<std::string> &keys)
+{
+    ObjectTimes best = { 1e300, 1e300, 0 };
+    for (int run = 0; run < RUNS; ++run) {
+        std::string err;
+        Clock::time_point start = Clock::now();
+        json11::Json document = json11::Json::parse(text, err);
+        double parse = millisecondsSince(start);
+        if (!err.empty()) {
+            std::cerr << "parse error: " << err << '\n';
+            std::exit(1);
+        }
+
+        long long checksum = 0;
+        start = Clock::now();
+        for (const auto &item: document.array_items()) {
+            for (const auto &key: keys)
+                checksum += item[key].int_value();
+        }
+        double lookup = millisecondsSince(start);
+
+        best.parse = std::min(best.parse, parse);
+        best.lookup = std::min(best.lookup, lookup);
+        best.checksum = checksum;
+    }
+    return best;
+}
+}
+
+#endif
@@ -0,0 +1,11 @@
+# Throughput of json11's string and whitespace scanners, scalar against
+# SSE2 and AVX2, and of whole parses of text dominated by long strings. The
+# benchmark compiles json11.cpp itself to reach the scanners.
+
+TEMPLATE = app
+TARGET = json11scan
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
@@ -0,0 +1,119 @@
+#include "../../json11.cpp"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace json11;
+
+namespace {
+const size_t BUFFER_SIZE = 64 * 1024 * 1024;
+const size_t RUN_LENGTHS[] = { 8, 32, 256, 4096 };
+const int RUNS = 5;
+
+typedef std::chrono::steady_clock Clock;
+typedef size_t (*Scanner)(const char *p, size_t n);
+
+struct Candidate
+{
+    const char *name;
+    Scanner whitespace;
+    Scanner string;
+};
+
+std::vector<Candidate> candidates()
+{
+    std::vector<Candidate> list;
+    list.push_back({ "scalar", scan_whitespace_scalar, scan_string_scalar });
+#ifdef JSON11_X86_SCAN
+    list.push_back({ "sse2", scan_whitespace_sse2, scan_string_sse2 });
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        list.push_back({ "avx2", scan_whitespace_avx2, scan_string_avx2 });
+#endif
+    return list;
+}
+
+// Runs of plain bytes, each ended by the byte stop.
+std::string makeRuns(char plain, char stop, size_t length)
+{
+    std::string text(BUFFER_SIZE, plain);
+    for (size_t i = length; i < text.size(); i += length + 1)
+        text[i] = stop;
+    return text;
+}
+
+// Scans the whole text run by run, as the parser does; best MB/s.
+double throughput(Scanner scanner, const std::string &text)
+{
+    double best = 0;
+    for (int run = 0; run < RUNS; ++run) {
+        Clock::time_point start = Clock::now();
+        size_t pos = 0;
+        while (pos < text.size())
+            pos += scanner(text.data() + pos, text.size() - pos) + 1;
+        double seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+        best = std::max(best, text.size() / seconds / 1e6);
+    }
+    return best;
+}
+
+// A .diag-like document whose labels are long, indented as by a pretty
+// printer; best MB/s of Json::parse() with the scanners the CPU selects.
+double parseThroughput()
+{
+    std::string text = "[\n";
+    for (int i = 0; text.size() < BUFFER_SIZE / 4; ++i) {
+        text += i ? ",\n        {" : "        {";
+        text += "\"index\": " + std::to_string(i) + ", \"text\": \"";
+        text.append(200 + i % 100, 'n');
+        text += "\\n";
+        text.append(50, 'm');
+        text += "\", \"x\": 10, \"y\": 20}";
+    }
+    text += "\n]\n";
+
+    double best = 0;
+    for (int run = 0; run < RUNS; ++run) {
+        std::string err;
+        Clock::time_point start = Clock::now();
+        Json json = Json::parse(text, err);
+        double seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+        if (!err.empty() || json.array_items().empty()) {
+            std::printf("parse error: %s\n", err.c_str());
+            std::exit(1);
+        }
+        best = std::max(best, text.size() / seconds / 1e6);
+    }
+    return best;
+}
+}
+
+int main()
+{
+    std::vector<Candidate> list = candidates();
+
+    std::printf("scanner throughput in MB/s by run length\n\n%-12s", "");
+    for (size_t length: RUN_LENGTHS)
+        std::printf(" %8zu", length);
+    std::printf("\n");
+
+    for (int isString = 0; isString < 2; ++isString) {
+        for (const auto &candidate: list) {
+            std::printf("%-6s %-5s", isString ? "string" : "space",
+                        candidate.name);
+            for (size_t length: RUN_LENGTHS) {
+                std::string text = isString ? makeRuns('a', '"', length)
+                                            : makeRuns(' ', 'a', length);
+                std::printf(" %8.0f", throughput(isString ? candidate.string
+                                                          : candidate.whitespace,
+                                                 text));
+            }
+            std::printf("\n");
+        }
+    }
+
+    std::printf("\nJson::parse of long labels: %.0f MB/s\n", parseThroughput());
+    return 0;
+}
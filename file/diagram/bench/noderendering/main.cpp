@@ -0,0 +1,189 @@
+#include <QtWidgets>
+#include <cstdio>
+
+#include "node.h"
+
+namespace {
+const int NODE_COUNT = 100000;
+const int COLUMNS = 316;
+const QPointF SPACING(100, 60);
+const QSize VIEW_SIZE(1600, 1000);
+// Scales from full detail down to points; see Node::setDetailThresholds().
+const qreal SCALES[] = { 1, 0.3, 0.1, 0.02 };
+const int FRAMES = 5;
+const int RUBBER_BAND_STEPS = 20;
+
+// Node as it was before it cached its outline: the label is measured on
+// every call of boundingRect(), shape() and paint(), and shape() builds its
+// path each time. Levels of detail are drawn as Node draws them.
+class UncachedNode : public Node
+{
+public:
+    explicit UncachedNode(int index) : Node(index) {}
+
+    QRectF boundingRect() const
+    {
+        const int Margin = 1;
+        return outline().adjusted(-Margin, -Margin, +Margin, +Margin);
+    }
+
+    QPainterPath shape() const
+    {
+        QRectF rect = outline();
+        QPainterPath path;
+        path.addRoundRect(rect, roundness(rect.width()),
+                          roundness(rect.height()));
+        return path;
+    }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget * /* widget */)
+    {
+        Detail detail = detailFor(option->levelOfDetailFromTransform(
+                                      painter->worldTransform()));
+        if (detail == PointDetail) {
+            painter->setPen(QPen(outlineColor(), 0));
+            painter->drawPoint(QPointF());
+            return;
+        }
+
+        QPen pen(outlineColor());
+        if (option->state & QStyle::State_Selected) {
+            pen.setStyle(Qt::DotLine);
+            pen.setWidth(2);
+        }
+        painter->setPen(pen);
+        painter->setBrush(backgroundColor());
+
+        QRectF rect = outline();
+        if (detail == RectDetail) {
+            painter->setRenderHint(QPainter::Antialiasing, false);
+            painter->drawRect(rect);
+            return;
+        }
+        painter->drawRoundRect(rect, roundness(rect.width()),
+                               roundness(rect.height()));
+        if (detail == OutlineDetail)
+            return;
+
+        painter->setPen(textColor());
+        painter->drawText(rect, Qt::AlignCenter, text());
+    }
+
+private:
+    QRectF outline() const
+    {
+        const int Padding = 8;
+        QFontMetricsF metrics(qApp->font());
+        QRectF rect = metrics.boundingRect(text());
+        rect.adjust(-Padding, -Padding, +Padding, +Padding);
+        rect.translate(-rect.center());
+        return rect;
+    }
+
+    static int roundness(double size)
+    {
+        const int Diameter = 12;
+        return 100 * Diameter / int(size);
+    }
+};
+
+double millisecondsSince(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+template <typename NodeType>
+void addNodes(QGraphicsScene &scene)
+{
+    for (int i = 0; i < NODE_COUNT; ++i) {
+        Node *node = new NodeType(i + 1);
+        node->setText(QString("Node %1").arg(i + 1));
+        node->setPos((i % COLUMNS) * SPACING.x(), (i / COLUMNS) * SPACING.y());
+        scene.addItem(node);
+    }
+}
+
+// Renders the view-sized area at the top left of the scene at a scale,
+// as QGraphicsView does on a full repaint; best time per frame.
+double repaint(QGraphicsScene &scene, qreal scale, int &items)
+{
+    QImage image(VIEW_SIZE, QImage::Format_ARGB32_Premultiplied);
+    QRectF source(QPointF(), QSizeF(VIEW_SIZE) / scale);
+    items = scene.items(source).size();
+
+    double best = 1e300;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        painter.setRenderHints(QPainter::Antialiasing
+                               | QPainter::TextAntialiasing);
+        QElapsedTimer timer;
+        timer.start();
+        scene.render(&painter, QRectF(image.rect()), source);
+        best = qMin(best, millisecondsSince(timer));
+    }
+    return best;
+}
+
+// A rubber band dragged from the top left corner to the far corner of the
+// scene, one selection update per step, as QGraphicsView makes them.
+double rubberBand(QGraphicsScene &scene, int &selected)
+{
+    QRectF bounds = scene.itemsBoundingRect();
+    QElapsedTimer timer;
+    timer.start();
+    for (int step = 1; step <= RUBBER_BAND_STEPS; ++step) {
+        qreal fraction = qreal(step) / RUBBER_BAND_STEPS;
+        QPainterPath band;
+        band.addRect(QRectF(bounds.topLeft(), bounds.size() * fraction));
+        scene.setSelectionArea(band, Qt::IntersectsItemShape);
+    }
+    double elapsed = millisecondsSince(timer);
+    selected = scene.selectedItems().size();
+    return elapsed;
+}
+
+template <typename NodeType>
+void run(const char *name)
+{
+    std::printf("%s\n", name);
+    QGraphicsScene scene;
+    QElapsedTimer timer;
+    timer.start();
+    addNodes<NodeType>(scene);
+    scene.items(QRectF(QPointF(), QSizeF(VIEW_SIZE)));
+    std::printf("  %d nodes added and indexed in %.1f ms\n", NODE_COUNT,
+                millisecondsSince(timer));
+
+    for (qreal scale: SCALES) {
+        int items = 0;
+        double elapsed = repaint(scene, scale, items);
+        std::printf("  repaint at scale %-5g %7d nodes %10.1f ms\n", scale,
+                    items, elapsed);
+    }
+
+    int selected = 0;
+    double elapsed = rubberBand(scene, selected);
+    std::printf("  rubber band in %d steps %12d nodes %10.1f ms\n",
+                RUBBER_BAND_STEPS, selected, elapsed);
+
+    timer.restart();
+    scene.clearSelection();
+    std::printf("  clearing the selection %30.1f ms\n\n",
+                millisecondsSince(timer));
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    std::printf("repaints of a %dx%d view are the best of %d frames\n\n",
+                VIEW_SIZE.width(), VIEW_SIZE.height(), FRAMES);
+    run<Node>("cached outline (Node)");
+    run<UncachedNode>("outline measured on every call");
+    return 0;
+}
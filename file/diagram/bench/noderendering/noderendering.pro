@@ -0,0 +1,16 @@
+# Repainting and rubber-band selecting a scene of 100k nodes, with Node as
+# it is, caching its outline rect and shape, against a node that measures
+# its label on every call as Node did before. Both run on the scene's
+# default BSP index. Runs without a display when QT_QPA_PLATFORM is unset,
+# on the offscreen platform.
+
+TEMPLATE = app
+TARGET = noderendering
+QT += widgets
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+
+HEADERS += ../../edgelayer.h
+SOURCES += main.cpp ../../node.cpp ../../link.cpp ../../edgelayer.cpp \
+           ../../graphmodel.cpp ../../json11.cpp
@@ -0,0 +1,123 @@
+#include <QtWidgets>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "diagramgridindex.h"
+
+namespace {
+const int ITEM_COUNTS[] = { 10000, 100000, 1000000 };
+// Scene units per item along each side, so that every scene has the
+// density of a laid-out diagram.
+const qreal SPACING = 100;
+const QSizeF ITEM_SIZE(60, 30);
+const QSizeF VIEW_SIZE(1600, 1000);
+const int QUERIES = 100;
+const int MOVE_ROUNDS = 10;
+
+enum Method { Bsp, NoIndex, Grid };
+
+const char *methodName(Method method)
+{
+    static const char *const NAMES[] = { "bsp", "noindex", "grid" };
+    return NAMES[method];
+}
+
+struct Times
+{
+    double add;
+    double query;
+    double move;
+    double itemAt;
+    qint64 checksum;
+};
+
+double millisecondsSince(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+// Adds count items, then times viewport queries, drags of 1% of the items
+// each followed by a query, and point hit tests. Every method gets the same
+// items and the same queries.
+Times run(Method method, int count)
+{
+    QGraphicsScene scene;
+    if (method == Grid)
+        DiagramGridIndex::install(&scene);
+    else if (method == NoIndex)
+        scene.setItemIndexMethod(QGraphicsScene::NoIndex);
+
+    qreal side = SPACING * qSqrt(count);
+    std::mt19937 random(count);
+    std::uniform_real_distribution<qreal> coordinate(0, side);
+    QRectF viewRect(QPointF(), VIEW_SIZE);
+    Times times = { 0, 0, 0, 0, 0 };
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<QGraphicsItem *> items;
+    items.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QGraphicsItem *item = scene.addRect(QRectF(QPointF(), ITEM_SIZE));
+        item->setPos(coordinate(random), coordinate(random));
+        items.push_back(item);
+    }
+    times.checksum += scene.items(viewRect).size();
+    times.add = millisecondsSince(timer);
+
+    timer.restart();
+    for (int i = 0; i < QUERIES; ++i) {
+        viewRect.moveTo(coordinate(random), coordinate(random));
+        times.checksum += scene.items(viewRect).size();
+    }
+    times.query = millisecondsSince(timer);
+
+    std::uniform_int_distribution<int> pick(0, count - 1);
+    timer.restart();
+    for (int round = 0; round < MOVE_ROUNDS; ++round) {
+        for (int i = 0; i < count / 100; ++i)
+            items[pick(random)]->moveBy(SPACING / 4, SPACING / 8);
+        times.checksum += scene.items(viewRect).size();
+    }
+    times.move = millisecondsSince(timer);
+
+    timer.restart();
+    for (int i = 0; i < QUERIES; ++i) {
+        QPointF point(coordinate(random), coordinate(random));
+        if (scene.itemAt(point, QTransform()))
+            ++times.checksum;
+    }
+    times.itemAt = millisecondsSince(timer);
+    return times;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    std::printf("times in ms; %d queries of a %gx%g view, %d rounds of "
+                "moving 1%% of the items\n\n", QUERIES, VIEW_SIZE.width(),
+                VIEW_SIZE.height(), MOVE_ROUNDS);
+    std::printf("%8s %-8s %10s %10s %10s %10s\n", "items", "index", "add",
+                "query", "move", "itemAt");
+
+    for (int count: ITEM_COUNTS) {
+        qint64 checksum = -1;
+        for (Method method: { Bsp, NoIndex, Grid }) {
+            Times times = run(method, count);
+            std::printf("%8d %-8s %10.1f %10.1f %10.1f %10.1f\n", count,
+                        methodName(method), times.add, times.query,
+                        times.move, times.itemAt);
+            if (checksum >= 0 && times.checksum != checksum) {
+                std::printf("indexes disagree for %d items\n", count);
+                return 1;
+            }
+            checksum = times.checksum;
+        }
+    }
+    return 0;
+}
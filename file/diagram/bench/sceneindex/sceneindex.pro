@@ -0,0 +1,14 @@
+# Qt's BSP tree and linear (NoIndex) scene indexes against DiagramGridIndex
+# on scenes of 10k, 100k and 1M node-sized items. Like the application it
+# needs Qt's private widgets headers. Runs without a display when
+# QT_QPA_PLATFORM is unset, on the offscreen platform.
+
+TEMPLATE = app
+TARGET = sceneindex
+QT += widgets widgets-private
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+
+HEADERS += ../../diagramgridindex.h
+SOURCES += main.cpp ../../diagramgridindex.cpp
@@ -7,11 +7,26 @@ TARGET = diagram
 DEPENDPATH += .
 INCLUDEPATH += .
 
-QT += widgets
-CONFIG += c++11
+# widgets-private is for DiagramGridIndex, which plugs into Qt's private
+# scene index interface. Qt keeps no compatibility for private headers, so
+# the build is tied to the Qt patch version it was compiled against and has
+# to be rebuilt, and maybe ported, whenever Qt is upgraded.
+QT += widgets widgets-private concurrent
+CONFIG += c++17
 
 # Input
-HEADERS += diagramwindow.h link.h node.h propertiesdialog.h json11.hpp
+HEADERS += diagramwindow.h link.h node.h propertiesdialog.h json11.hpp \
+           diagramrecord.h diagramreader.h diagrambinary.h \
+           diagramjournal.h diagramsaver.h \
+           diagramloader.h diagramwriter.h diagramparallelreader.h \
+           diagramtiles.h graphmodel.h slotmap.h edgelayer.h \
+           diagramgridindex.h diagramstore.h smallvector.h diagramgrid.h \
+           linkitem.h
 FORMS += propertiesdialog.ui
-SOURCES += diagramwindow.cpp link.cpp main.cpp node.cpp propertiesdialog.cpp json11.cpp
+SOURCES += diagramwindow.cpp link.cpp main.cpp node.cpp propertiesdialog.cpp json11.cpp \
+           diagramreader.cpp diagrambinary.cpp \
+           diagramjournal.cpp diagramsaver.cpp \
+           diagramloader.cpp diagramwriter.cpp diagramparallelreader.cpp \
+           diagramtiles.cpp graphmodel.cpp edgelayer.cpp \
+           diagramgridindex.cpp diagramstore.cpp linkitem.cpp
 RESOURCES += resources.qrc
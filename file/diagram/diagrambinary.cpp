@@ -0,0 +1,227 @@
+#include <QByteArray>
+#include <QIODevice>
+#include <QtEndian>
+#include <cstring>
+
+#include "diagrambinary.h"
+
+namespace {
+const char MAGIC[4] = { 'D', 'I', 'A', 'B' };
+const quint32 VERSION = 2;
+const size_t HEADER_SIZE = 32;
+const size_t NODE_COLUMNS = 6;
+const int FLUSH_SIZE = 64 * 1024;
+
+const size_t SNAPSHOT_OFFSET = 20;
+
+quint32 readU32(const char *column, size_t i)
+{
+    return qFromLittleEndian<quint32>(
+                reinterpret_cast<const uchar *>(column + 4 * i));
+}
+
+qint32 readI32(const char *column, size_t i)
+{
+    return qFromLittleEndian<qint32>(
+                reinterpret_cast<const uchar *>(column + 4 * i));
+}
+
+// Little-endian output through a bounded buffer.
+class ColumnWriter
+{
+public:
+    explicit ColumnWriter(QIODevice *device) : myDevice(device), myOk(true)
+    {
+        myBuffer.reserve(FLUSH_SIZE + 4);
+    }
+
+    void putU64(quint64 value)
+    {
+        uchar bytes[8];
+        qToLittleEndian<quint64>(value, bytes);
+        put(reinterpret_cast<const char *>(bytes), 8);
+    }
+
+    void putU32(quint32 value)
+    {
+        uchar bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        put(reinterpret_cast<const char *>(bytes), 4);
+    }
+
+    void put(const char *data, int size)
+    {
+        if (myBuffer.size() + size > FLUSH_SIZE)
+            flush();
+        if (size > FLUSH_SIZE)
+            myOk = myOk && myDevice->write(data, size) == size;
+        else
+            myBuffer.append(data, size);
+    }
+
+    bool flush()
+    {
+        if (!myBuffer.isEmpty()) {
+            myOk = myOk && myDevice->write(myBuffer) == myBuffer.size();
+            myBuffer.clear();
+        }
+        return myOk;
+    }
+
+private:
+    QIODevice *myDevice;
+    QByteArray myBuffer;
+    bool myOk;
+};
+}
+
+bool DiagramBinary::isBinary(const char *data, size_t size)
+{
+    return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+DiagramBinaryReader::DiagramBinaryReader(
+        const DiagramReader::NodeCallback &nodeCallback,
+        const DiagramReader::LinkCallback &linkCallback)
+    : myNodeCallback(nodeCallback), myLinkCallback(linkCallback),
+      mySnapshotId(0)
+{
+}
+
+// Zero for files written without one.
+quint64 DiagramBinaryReader::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+bool DiagramBinaryReader::read(const char *data, size_t size,
+                               std::string &err)
+{
+    if (size < HEADER_SIZE || !DiagramBinary::isBinary(data, size)) {
+        err = "not a binary diagram";
+        return false;
+    }
+    quint32 version = readU32(data, 1);
+    if (version != 1 && version != VERSION) {
+        err = "unsupported binary diagram version";
+        return false;
+    }
+    size_t linkColumns = version == 1 ? 2 : 3;
+
+    quint64 nodeCount = readU32(data, 2);
+    quint64 linkCount = readU32(data, 3);
+    quint64 stringSize = readU32(data, 4);
+    mySnapshotId = qFromLittleEndian<quint64>(
+                reinterpret_cast<const uchar *>(data + SNAPSHOT_OFFSET));
+    quint64 expected = HEADER_SIZE
+            + 4 * ((NODE_COLUMNS + 1) * nodeCount + 1
+                   + linkColumns * linkCount)
+            + stringSize;
+    if (expected > size) {
+        err = "truncated binary diagram";
+        return false;
+    }
+
+    const char *indexes = data + HEADER_SIZE;
+    const char *xs = indexes + 4 * nodeCount;
+    const char *ys = xs + 4 * nodeCount;
+    const char *textColors = ys + 4 * nodeCount;
+    const char *outlineColors = textColors + 4 * nodeCount;
+    const char *backgroundColors = outlineColors + 4 * nodeCount;
+    const char *textOffsets = backgroundColors + 4 * nodeCount;
+    const char *froms = textOffsets + 4 * (nodeCount + 1);
+    const char *tos = froms + 4 * linkCount;
+    const char *colors = tos + 4 * linkCount;
+    const char *strings = froms + 4 * linkColumns * linkCount;
+
+    NodeRecord node;
+    node.hasColors = true;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        quint32 begin = readU32(textOffsets, i);
+        quint32 end = readU32(textOffsets, i + 1);
+        if (begin > end || end > stringSize) {
+            err = "invalid label offset in binary diagram";
+            return false;
+        }
+
+        node.index = readI32(indexes, i);
+        node.x = readI32(xs, i);
+        node.y = readI32(ys, i);
+        node.textColor = readU32(textColors, i);
+        node.outlineColor = readU32(outlineColors, i);
+        node.backgroundColor = readU32(backgroundColors, i);
+        node.text.assign(strings + begin, end - begin);
+        if (!myNodeCallback(node)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+
+    LinkRecord link;
+    for (size_t i = 0; i < linkCount; ++i) {
+        link.from = readI32(froms, i);
+        link.to = readI32(tos, i);
+        link.color = version == 1 ? 0 : readU32(colors, i);
+        if (!myLinkCallback(link)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DiagramBinaryWriter::write(QIODevice *device,
+                                const std::vector<NodeRecord> &nodes,
+                                const std::vector<LinkRecord> &links,
+                                quint64 snapshotId)
+{
+    quint64 stringSize = 0;
+    for (const auto &node: nodes)
+        stringSize += node.text.size();
+    if (nodes.size() > 0xffffffffu || links.size() > 0xffffffffu
+            || stringSize > 0xffffffffu)
+        return false;
+
+    ColumnWriter out(device);
+    out.put(MAGIC, sizeof(MAGIC));
+    out.putU32(VERSION);
+    out.putU32(nodes.size());
+    out.putU32(links.size());
+    out.putU32(stringSize);
+    out.putU64(snapshotId);
+    for (size_t i = SNAPSHOT_OFFSET + 8; i < HEADER_SIZE; i += 4)
+        out.putU32(0);
+
+    for (const auto &node: nodes)
+        out.putU32(node.index);
+    for (const auto &node: nodes)
+        out.putU32(node.x);
+    for (const auto &node: nodes)
+        out.putU32(node.y);
+    for (const auto &node: nodes)
+        out.putU32(node.textColor);
+    for (const auto &node: nodes)
+        out.putU32(node.outlineColor);
+    for (const auto &node: nodes)
+        out.putU32(node.backgroundColor);
+
+    quint32 offset = 0;
+    out.putU32(offset);
+    for (const auto &node: nodes) {
+        offset += node.text.size();
+        out.putU32(offset);
+    }
+
+    for (const auto &link: links)
+        out.putU32(link.from);
+    for (const auto &link: links)
+        out.putU32(link.to);
+    for (const auto &link: links)
+        out.putU32(link.color);
+
+    for (const auto &node: nodes)
+        out.put(node.text.data(), node.text.size());
+
+    return out.flush();
+}
@@ -0,0 +1,52 @@
+#ifndef DIAGRAMBINARY_H
+#define DIAGRAMBINARY_H
+
+#include <QtGlobal>
+#include <string>
+#include <vector>
+#include "diagramreader.h"
+#include "diagramrecord.h"
+
+class QIODevice;
+
+// The .diagb format: a 32-byte header followed by packed little-endian
+// 32-bit columns and a UTF-8 string table, so a memory-mapped file can be
+// read in place without any text parsing.
+//
+//   header   "DIAB", version, node count n, link count m,
+//            string table size, 64-bit snapshot id, 4 reserved bytes
+//   nodes    index[n], x[n], y[n], textColor[n], outlineColor[n],
+//            backgroundColor[n], textOffset[n + 1]
+//   links    from[m], to[m], color[m]
+//   strings  node labels; label i is bytes textOffset[i]..textOffset[i + 1]
+//
+// Version 1 files have no link colors.
+namespace DiagramBinary {
+bool isBinary(const char *data, size_t size);
+}
+
+class DiagramBinaryReader
+{
+public:
+    DiagramBinaryReader(const DiagramReader::NodeCallback &nodeCallback,
+                        const DiagramReader::LinkCallback &linkCallback);
+
+    bool read(const char *data, size_t size, std::string &err);
+    quint64 snapshotId() const;
+
+private:
+    DiagramReader::NodeCallback myNodeCallback;
+    DiagramReader::LinkCallback myLinkCallback;
+    quint64 mySnapshotId;
+};
+
+class DiagramBinaryWriter
+{
+public:
+    static bool write(QIODevice *device,
+                      const std::vector<NodeRecord> &nodes,
+                      const std::vector<LinkRecord> &links,
+                      quint64 snapshotId);
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef DIAGRAMGRID_H
+#define DIAGRAMGRID_H
+
+#include <QRect>
+#include <QRectF>
+#include <QtMath>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Values kept over scene rects in a stack of square-cell grids. Each
+// level's cells are twice the size of the level below, and a value goes to
+// the lowest level whose cells are at least as large as its rect, so it is
+// in at most four cells. The grids are unbounded and store only occupied
+// cells. Values too large for the top level are kept apart and returned by
+// every query. T is hashed and compared, and is meant to be a pointer.
+template <typename T>
+class DiagramGrid
+{
+public:
+    // Where insert() put a value; remove() takes it back.
+    struct Place
+    {
+        int level;
+        QRect cells;
+    };
+
+    explicit DiagramGrid(qreal cellSize = 256) : myCellSize(cellSize) {}
+
+    Place insert(const T &value, const QRectF &rect)
+    {
+        qreal extent = qMax(rect.width(), rect.height());
+        Place place;
+        place.level = 0;
+        while (place.level < LEVEL_COUNT && extent > cellSize(place.level))
+            ++place.level;
+        if (place.level == LEVEL_COUNT) {
+            myOversized.insert(value);
+            return place;
+        }
+
+        place.cells = cellRange(rect, place.level);
+        Level &grid = myLevels[place.level];
+        ++grid.count;
+        Slot slot = { value, place.cells };
+        for (int y = place.cells.top(); y <= place.cells.bottom(); ++y) {
+            for (int x = place.cells.left(); x <= place.cells.right(); ++x)
+                grid.cells[cellKey(x, y)].push_back(slot);
+        }
+        return place;
+    }
+
+    void remove(const T &value, const Place &place)
+    {
+        if (place.level == LEVEL_COUNT) {
+            myOversized.erase(value);
+            return;
+        }
+
+        Level &grid = myLevels[place.level];
+        --grid.count;
+        for (int y = place.cells.top(); y <= place.cells.bottom(); ++y) {
+            for (int x = place.cells.left(); x <= place.cells.right(); ++x) {
+                auto iter = grid.cells.find(cellKey(x, y));
+                if (iter == grid.cells.end())
+                    continue;
+                std::vector<Slot> &slots = iter->second;
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    if (slots[i].value == value) {
+                        slots[i] = slots.back();
+                        slots.pop_back();
+                        break;
+                    }
+                }
+                if (slots.empty())
+                    grid.cells.erase(iter);
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (auto &grid: myLevels) {
+            grid.cells.clear();
+            grid.count = 0;
+        }
+        myOversized.clear();
+    }
+
+    // Calls visit once for each value whose cells meet rect, and for each
+    // oversized value. On a level where rect covers more cells than are
+    // occupied, the occupied cells are walked instead of the covered ones.
+    template <typename Visit>
+    void query(const QRectF &rect, Visit visit) const
+    {
+        for (int i = 0; i < LEVEL_COUNT; ++i) {
+            const Level &grid = myLevels[i];
+            if (grid.count == 0)
+                continue;
+
+            QRect range = cellRange(rect, i);
+            // A value in several cells is visited from the first of them
+            // that rect covers.
+            auto visitCell = [&](int x, int y, const std::vector<Slot> &slots) {
+                for (const Slot &slot: slots) {
+                    if (x == qMax(slot.cells.left(), range.left())
+                            && y == qMax(slot.cells.top(), range.top()))
+                        visit(slot.value);
+                }
+            };
+
+            if (qint64(range.width()) * range.height()
+                    > qint64(grid.cells.size())) {
+                for (const auto &cell: grid.cells) {
+                    int x = int(quint32(cell.first >> 32));
+                    int y = int(quint32(cell.first));
+                    if (range.contains(x, y))
+                        visitCell(x, y, cell.second);
+                }
+                continue;
+            }
+
+            for (int y = range.top(); y <= range.bottom(); ++y) {
+                for (int x = range.left(); x <= range.right(); ++x) {
+                    auto iter = grid.cells.find(cellKey(x, y));
+                    if (iter != grid.cells.end())
+                        visitCell(x, y, iter->second);
+                }
+            }
+        }
+        for (const T &value: myOversized)
+            visit(value);
+    }
+
+private:
+    enum { LEVEL_COUNT = 16 };
+
+    struct Slot
+    {
+        T value;
+        QRect cells;
+    };
+
+    struct Level
+    {
+        std::unordered_map<quint64, std::vector<Slot> > cells;
+        size_t count;
+
+        Level() : count(0) {}
+    };
+
+    qreal cellSize(int level) const
+    {
+        return std::ldexp(myCellSize, level);
+    }
+
+    // Cell coordinates are clamped so that huge rects stay in range.
+    QRect cellRange(const QRectF &rect, int level) const
+    {
+        const qreal limit = 1 << 29;
+        qreal size = cellSize(level);
+        return QRect(QPoint(qFloor(qBound(-limit, rect.left() / size, limit)),
+                            qFloor(qBound(-limit, rect.top() / size, limit))),
+                     QPoint(qFloor(qBound(-limit, rect.right() / size, limit)),
+                            qFloor(qBound(-limit, rect.bottom() / size, limit))));
+    }
+
+    static quint64 cellKey(int x, int y)
+    {
+        return (quint64(quint32(x)) << 32) | quint32(y);
+    }
+
+    qreal myCellSize;
+    Level myLevels[LEVEL_COUNT];
+    std::unordered_set<T> myOversized;
+};
+
+#endif
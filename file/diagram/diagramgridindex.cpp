@@ -0,0 +1,142 @@
+#include <QtWidgets>
+#include <private/qgraphicsitem_p.h>
+#include <private/qgraphicsscene_p.h>
+#include <algorithm>
+
+#include "diagramgridindex.h"
+
+DiagramGridIndex::DiagramGridIndex(QGraphicsScene *scene, qreal cellSize)
+    : QGraphicsSceneIndex(scene), myGrid(cellSize), myStamp(0)
+{
+}
+
+// Replaces the index of an empty scene.
+void DiagramGridIndex::install(QGraphicsScene *scene)
+{
+    scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    QGraphicsScenePrivate *d = QGraphicsScenePrivate::get(scene);
+    delete d->index;
+    d->index = new DiagramGridIndex(scene);
+}
+
+QList<QGraphicsItem *> DiagramGridIndex::items(Qt::SortOrder order) const
+{
+    QList<QGraphicsItem *> items;
+    items.reserve(myEntries.size());
+    for (const auto &entry: myEntries)
+        items.append(entry.second.item);
+    sortItems(items, order);
+    return items;
+}
+
+QList<QGraphicsItem *> DiagramGridIndex::estimateItems(
+        const QRectF &rect, Qt::SortOrder order) const
+{
+    QList<QGraphicsItem *> items = query(rect, false);
+    sortItems(items, order);
+    return items;
+}
+
+QList<QGraphicsItem *> DiagramGridIndex::estimateTopLevelItems(
+        const QRectF &rect, Qt::SortOrder order) const
+{
+    QList<QGraphicsItem *> items = query(rect, true);
+    sortItems(items, order);
+    return items;
+}
+
+void DiagramGridIndex::clear()
+{
+    myEntries.clear();
+    myGrid.clear();
+    myPending.clear();
+}
+
+// Items are linked into cells by the first query after they are added, so
+// adding many items in a row costs no geometry work.
+void DiagramGridIndex::addItem(QGraphicsItem *item)
+{
+    Entry &entry = myEntries[item];
+    entry.item = item;
+    entry.state = Pending;
+    entry.stamp = myStamp;
+    myPending.insert(&entry);
+}
+
+void DiagramGridIndex::removeItem(QGraphicsItem *item)
+{
+    auto iter = myEntries.find(item);
+    if (iter == myEntries.end())
+        return;
+    unlink(iter->second);
+    myEntries.erase(iter);
+}
+
+// Called before an item moves or changes its bounds.
+void DiagramGridIndex::prepareBoundingRectChange(const QGraphicsItem *item)
+{
+    auto iter = myEntries.find(item);
+    if (iter == myEntries.end() || iter->second.state == Pending)
+        return;
+    unlink(iter->second);
+    iter->second.state = Pending;
+    myPending.insert(&iter->second);
+}
+
+void DiagramGridIndex::link(Entry &entry) const
+{
+    entry.state = Indexed;
+    entry.place = myGrid.insert(&entry, entry.item->sceneBoundingRect());
+}
+
+void DiagramGridIndex::unlink(Entry &entry) const
+{
+    if (entry.state == Pending)
+        myPending.erase(&entry);
+    else
+        myGrid.remove(&entry, entry.place);
+}
+
+void DiagramGridIndex::processPending() const
+{
+    for (Entry *entry: myPending)
+        link(*entry);
+    myPending.clear();
+}
+
+// Returns each item whose cells meet rect once. Child items are reported
+// as their top-level item if topLevelOnly is set.
+QList<QGraphicsItem *> DiagramGridIndex::query(const QRectF &rect,
+                                               bool topLevelOnly) const
+{
+    processPending();
+
+    QList<QGraphicsItem *> items;
+    quint32 stamp = ++myStamp;
+    auto collect = [&](Entry *entry) {
+        QGraphicsItem *item = entry->item;
+        if (topLevelOnly && item->parentItem()) {
+            item = item->topLevelItem();
+            auto iter = myEntries.find(item);
+            if (iter == myEntries.end())
+                return;
+            entry = &iter->second;
+        }
+        if (entry->stamp != stamp) {
+            entry->stamp = stamp;
+            items.append(item);
+        }
+    };
+
+    myGrid.query(rect, collect);
+    return items;
+}
+
+void DiagramGridIndex::sortItems(QList<QGraphicsItem *> &items,
+                                 Qt::SortOrder order)
+{
+    if (order == Qt::AscendingOrder)
+        std::sort(items.begin(), items.end(), qt_closestItemLast);
+    else if (order == Qt::DescendingOrder)
+        std::sort(items.begin(), items.end(), qt_closestItemFirst);
+}
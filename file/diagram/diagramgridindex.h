@@ -0,0 +1,68 @@
+#ifndef DIAGRAMGRIDINDEX_H
+#define DIAGRAMGRIDINDEX_H
+
+#include <private/qgraphicssceneindex_p.h>
+#include <unordered_map>
+#include <unordered_set>
+#include "diagramgrid.h"
+
+// A scene item index over a DiagramGrid, for scenes whose items move all
+// the time. Qt's BSP tree has to be rebuilt as items move and the scene
+// grows; here a moved item is only taken out of the grid, and it is put
+// back at its new place by the next query. The grid is unbounded, so
+// growing past the scene rect costs nothing.
+//
+// The index plugs into QGraphicsScene through Qt's private scene index
+// interface, so it drives painting, rubber-band selection and itemAt().
+class DiagramGridIndex : public QGraphicsSceneIndex
+{
+    Q_OBJECT
+
+public:
+    explicit DiagramGridIndex(QGraphicsScene *scene, qreal cellSize = 256);
+
+    static void install(QGraphicsScene *scene);
+
+    using QGraphicsSceneIndex::items;
+    using QGraphicsSceneIndex::estimateItems;
+
+    QList<QGraphicsItem *> items(Qt::SortOrder order = Qt::DescendingOrder) const;
+    QList<QGraphicsItem *> estimateItems(const QRectF &rect,
+                                         Qt::SortOrder order) const;
+    QList<QGraphicsItem *> estimateTopLevelItems(const QRectF &rect,
+                                                 Qt::SortOrder order) const;
+
+protected:
+    void clear();
+    void addItem(QGraphicsItem *item);
+    void removeItem(QGraphicsItem *item);
+    void prepareBoundingRectChange(const QGraphicsItem *item);
+
+private:
+    enum State { Pending, Indexed };
+
+    struct Entry;
+    typedef DiagramGrid<Entry *> Grid;
+
+    struct Entry
+    {
+        QGraphicsItem *item;
+        State state;
+        Grid::Place place;
+        quint32 stamp;
+    };
+
+    void link(Entry &entry) const;
+    void unlink(Entry &entry) const;
+    void processPending() const;
+    QList<QGraphicsItem *> query(const QRectF &rect, bool topLevelOnly) const;
+    static void sortItems(QList<QGraphicsItem *> &items, Qt::SortOrder order);
+
+    // Queries are const but link pending items first.
+    mutable std::unordered_map<const QGraphicsItem *, Entry> myEntries;
+    mutable Grid myGrid;
+    mutable std::unordered_set<Entry *> myPending;
+    mutable quint32 myStamp;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <iostream>
+
+#include "diagramjournal.h"
+#include "json11.hpp"
+
+using json11::Json;
+using json11::JsonDocument;
+
+namespace {
+std::string colorName(unsigned int rgba)
+{
+    return QColor::fromRgba(rgba).name(QColor::HexArgb).toStdString();
+}
+
+unsigned int colorValue(const Json &json)
+{
+    return QColor(QString::fromStdString(json.string_value())).rgba();
+}
+
+Json::object colorFields(const NodeRecord &record)
+{
+    return Json::object({
+        {"index", record.index},
+        {"textColor", colorName(record.textColor)},
+        {"outlineColor", colorName(record.outlineColor)},
+        {"backgroundColor", colorName(record.backgroundColor)}
+    });
+}
+}
+
+// A zero snapshot id stands for a file written without one; the size of
+// the file is then all that ties the journal to it.
+DiagramJournal::DiagramJournal(const QString &fileName, quint64 snapshotId)
+    : myFileName(fileName)
+{
+    if (snapshotId)
+        mySnapshotId = QString("%1").arg(snapshotId, 16, 16, QChar('0'))
+                       .toStdString();
+}
+
+QString DiagramJournal::pathFor(const QString &fileName)
+{
+    return fileName + ".journal";
+}
+
+void DiagramJournal::addNode(const NodeRecord &record)
+{
+    Json::object obj = colorFields(record);
+    obj["op"] = "addNode";
+    obj["text"] = record.text;
+    obj["x"] = record.x;
+    obj["y"] = record.y;
+    appendLine(obj);
+}
+
+void DiagramJournal::moveNode(int index, int x, int y)
+{
+    Json obj = Json::object({
+        {"op", "moveNode"},
+        {"index", index},
+        {"x", x},
+        {"y", y}
+    });
+    appendLine(obj);
+}
+
+void DiagramJournal::renameNode(int index, const std::string &text)
+{
+    Json obj = Json::object({
+        {"op", "renameNode"},
+        {"index", index},
+        {"text", text}
+    });
+    appendLine(obj);
+}
+
+void DiagramJournal::recolorNode(const NodeRecord &record)
+{
+    Json::object obj = colorFields(record);
+    obj["op"] = "recolorNode";
+    appendLine(obj);
+}
+
+void DiagramJournal::removeNode(int index)
+{
+    Json obj = Json::object({
+        {"op", "removeNode"},
+        {"index", index}
+    });
+    appendLine(obj);
+}
+
+// A link with the default color is written without one.
+void DiagramJournal::addLink(const LinkRecord &record)
+{
+    Json::object obj = Json::object({
+        {"op", "addLink"},
+        {"from", record.from},
+        {"to", record.to}
+    });
+    if (record.color)
+        obj["color"] = colorName(record.color);
+    appendLine(obj);
+}
+
+void DiagramJournal::removeLink(const LinkRecord &record)
+{
+    Json obj = Json::object({
+        {"op", "removeLink"},
+        {"from", record.from},
+        {"to", record.to}
+    });
+    appendLine(obj);
+}
+
+void DiagramJournal::recolorLink(const LinkRecord &record)
+{
+    Json obj = Json::object({
+        {"op", "recolorLink"},
+        {"from", record.from},
+        {"to", record.to},
+        {"color", colorName(record.color)}
+    });
+    appendLine(obj);
+}
+
+void DiagramJournal::appendLine(const Json &obj)
+{
+    std::string line = obj.dump();
+    myPending.append(line.data(), int(line.size()));
+    myPending.append('\n');
+}
+
+bool DiagramJournal::isEmpty() const
+{
+    return myPending.isEmpty();
+}
+
+bool DiagramJournal::commit()
+{
+    if (myPending.isEmpty())
+        return true;
+
+    QFile file(pathFor(myFileName));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+
+    if (file.size() == 0) {
+        Json header = Json::object({
+            {"op", "journal"},
+            {"snapshot", mySnapshotId},
+            {"snapshotSize", double(QFileInfo(myFileName).size())}
+        });
+        myPending.prepend(QByteArray::fromStdString(header.dump() + '\n'));
+    }
+
+    if (file.write(myPending) != myPending.size() || !file.flush())
+        return false;
+
+    myPending.clear();
+    return true;
+}
+
+qint64 DiagramJournal::size() const
+{
+    return QFileInfo(pathFor(myFileName)).size();
+}
+
+bool DiagramJournal::remove()
+{
+    QString path = pathFor(myFileName);
+    return !QFile::exists(path) || QFile::remove(path);
+}
+
+bool DiagramJournal::replay(Handler &handler) const
+{
+    QFile file(pathFor(myFileName));
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // One document for all lines, so that its arena is reused from line to
+    // line; the values of a line are done with before the next is parsed.
+    JsonDocument document;
+    bool first = true;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.endsWith('\n')) {
+            std::cerr << "ignoring incomplete journal record\n";
+            break;
+        }
+
+        std::string err;
+        if (!document.parse(line.constData(), line.size(), err)) {
+            std::cerr << "parse journal error: " << err << '\n';
+            return false;
+        }
+
+        const Json &json = document.root();
+        const std::string &op = json["op"].string_value();
+        if (first) {
+            first = false;
+            if (op != "journal"
+                    || json["snapshot"].string_value() != mySnapshotId
+                    || json["snapshotSize"].number_value()
+                       != double(QFileInfo(myFileName).size())) {
+                std::cerr << "journal does not match "
+                          << myFileName.toStdString() << ", ignored\n";
+                return true;
+            }
+            continue;
+        }
+
+        if (op == "addNode") {
+            NodeRecord record;
+            record.index = json["index"].int_value();
+            record.text = json["text"].string_value();
+            record.x = json["x"].int_value();
+            record.y = json["y"].int_value();
+            record.hasColors = true;
+            record.textColor = colorValue(json["textColor"]);
+            record.outlineColor = colorValue(json["outlineColor"]);
+            record.backgroundColor = colorValue(json["backgroundColor"]);
+            handler.addNode(record);
+        } else if (op == "moveNode") {
+            handler.moveNode(json["index"].int_value(),
+                             json["x"].int_value(), json["y"].int_value());
+        } else if (op == "renameNode") {
+            handler.renameNode(json["index"].int_value(),
+                               json["text"].string_value());
+        } else if (op == "recolorNode") {
+            NodeRecord record;
+            record.index = json["index"].int_value();
+            record.hasColors = true;
+            record.textColor = colorValue(json["textColor"]);
+            record.outlineColor = colorValue(json["outlineColor"]);
+            record.backgroundColor = colorValue(json["backgroundColor"]);
+            handler.recolorNode(record);
+        } else if (op == "removeNode") {
+            handler.removeNode(json["index"].int_value());
+        } else if (op == "addLink" || op == "removeLink"
+                   || op == "recolorLink") {
+            LinkRecord record;
+            record.from = json["from"].int_value();
+            record.to = json["to"].int_value();
+            record.color = json["color"].is_string()
+                           ? colorValue(json["color"]) : 0;
+            if (op == "addLink")
+                handler.addLink(record);
+            else if (op == "removeLink")
+                handler.removeLink(record);
+            else
+                handler.recolorLink(record);
+        } else {
+            std::cerr << "unknown journal record " << op << '\n';
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef DIAGRAMJOURNAL_H
+#define DIAGRAMJOURNAL_H
+
+#include <QByteArray>
+#include <QString>
+#include "diagramrecord.h"
+#include "json11.hpp"
+
+// Append-only log of edits made since a diagram file was last written in
+// full. The journal lives next to the file ("<file>.journal") and holds
+// one JSON object per line. The first line records the snapshot id and the
+// size of the file it applies to, so a journal left behind by another
+// snapshot, such as one whose removal was cut short after the file was
+// rewritten, is ignored.
+class DiagramJournal
+{
+public:
+    // Receiver for replay(); records arrive in the order they were written.
+    class Handler
+    {
+    public:
+        virtual void addNode(const NodeRecord &record) = 0;
+        virtual void moveNode(int index, int x, int y) = 0;
+        virtual void renameNode(int index, const std::string &text) = 0;
+        virtual void recolorNode(const NodeRecord &record) = 0;
+        virtual void removeNode(int index) = 0;
+        virtual void addLink(const LinkRecord &record) = 0;
+        virtual void removeLink(const LinkRecord &record) = 0;
+        virtual void recolorLink(const LinkRecord &record) = 0;
+        virtual ~Handler() {}
+    };
+
+    DiagramJournal(const QString &fileName, quint64 snapshotId);
+
+    static QString pathFor(const QString &fileName);
+
+    void addNode(const NodeRecord &record);
+    void moveNode(int index, int x, int y);
+    void renameNode(int index, const std::string &text);
+    void recolorNode(const NodeRecord &record);
+    void removeNode(int index);
+    void addLink(const LinkRecord &record);
+    void removeLink(const LinkRecord &record);
+    void recolorLink(const LinkRecord &record);
+
+    bool isEmpty() const;
+    bool commit();
+    qint64 size() const;
+    bool remove();
+
+    bool replay(Handler &handler) const;
+
+private:
+    void appendLine(const json11::Json &obj);
+
+    QString myFileName;
+    std::string mySnapshotId;
+    QByteArray myPending;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include <QFile>
+#include <QtConcurrent>
+#include <iostream>
+
+#include "diagrambinary.h"
+#include "diagramloader.h"
+#include "diagramparallelreader.h"
+#include "diagramreader.h"
+
+namespace {
+const size_t BATCH_SIZE = 1000;
+const size_t MAX_QUEUED_BATCHES = 8;
+const qint64 CHUNK_SIZE = 64 * 1024;
+}
+
+DiagramLoader::DiagramLoader(QObject *parent)
+    : QObject(parent), myBusy(false), myCancelled(false), mySnapshotId(0)
+{
+    connect(&myWatcher, SIGNAL(finished()), this, SLOT(readFinished()));
+}
+
+DiagramLoader::~DiagramLoader()
+{
+    cancel();
+    myWatcher.waitForFinished();
+}
+
+bool DiagramLoader::isBusy() const
+{
+    return myBusy;
+}
+
+void DiagramLoader::start(const QString &fileName)
+{
+    cancel();
+    myWatcher.waitForFinished();
+
+    myFileName = fileName;
+    myCancelled = false;
+    mySnapshotId = 0;
+    myBatch = Batch();
+    myQueue.clear();
+    myBusy = true;
+    myWatcher.setFuture(QtConcurrent::run(this, &DiagramLoader::read));
+}
+
+void DiagramLoader::cancel()
+{
+    QMutexLocker locker(&myMutex);
+    myCancelled = true;
+    myQueueNotFull.wakeAll();
+}
+
+bool DiagramLoader::takeBatch(std::vector<NodeRecord> &nodes,
+                              std::vector<LinkRecord> &links)
+{
+    QMutexLocker locker(&myMutex);
+    if (myQueue.empty())
+        return false;
+
+    nodes.swap(myQueue.front().nodes);
+    links.swap(myQueue.front().links);
+    myQueue.pop_front();
+    myQueueNotFull.wakeAll();
+    return true;
+}
+
+// The id stored in the file, or zero; valid once finished() has been
+// emitted.
+quint64 DiagramLoader::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+void DiagramLoader::readFinished()
+{
+    if (!myBusy)
+        return;
+
+    myBusy = false;
+    emit finished(myFileName, myWatcher.result());
+}
+
+// Runs on the worker thread.
+int DiagramLoader::read()
+{
+    QFile file(myFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return OpenFailed;
+
+    auto nodeCallback = [this](const NodeRecord &record) {
+        return addNode(record);
+    };
+    auto linkCallback = [this](const LinkRecord &record) {
+        return addLink(record);
+    };
+
+    QByteArray contents;
+    const char *data = 0;
+    size_t size = 0;
+    uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : 0;
+    if (mapped) {
+        data = reinterpret_cast<const char *>(mapped);
+        size = file.size();
+    } else {
+        // Pipes and other sequential files: parse text as it arrives.
+        QByteArray head = file.peek(4);
+        if (!DiagramBinary::isBinary(head.constData(), head.size())) {
+            DiagramReader reader(nodeCallback, linkCallback);
+            return readStream(file, reader);
+        }
+
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    std::string err;
+    bool ok;
+    if (DiagramBinary::isBinary(data, size)) {
+        DiagramBinaryReader reader(nodeCallback, linkCallback);
+        ok = reader.read(data, size, err);
+        mySnapshotId = reader.snapshotId();
+    } else {
+        DiagramParallelReader reader(nodeCallback, linkCallback);
+        ok = reader.read(data, size, err);
+        mySnapshotId = reader.snapshotId();
+    }
+
+    if (myCancelled)
+        return Cancelled;
+    if (!ok) {
+        std::cerr << "parse file error: " << err << '\n';
+        return ParseFailed;
+    }
+    return flush() ? Loaded : Cancelled;
+}
+
+// Runs on the worker thread.
+int DiagramLoader::readStream(QFile &file, DiagramReader &reader)
+{
+    QByteArray chunk;
+    std::string err;
+    bool ok = true;
+    while (ok) {
+        chunk = file.read(CHUNK_SIZE);
+        if (chunk.isEmpty())
+            break;
+        ok = reader.readChunk(chunk.constData(), chunk.size(), err);
+    }
+    ok = ok && reader.finish(err);
+    mySnapshotId = reader.snapshotId();
+
+    if (myCancelled)
+        return Cancelled;
+    if (!ok) {
+        std::cerr << "parse file error: " << err << '\n';
+        return ParseFailed;
+    }
+    return flush() ? Loaded : Cancelled;
+}
+
+bool DiagramLoader::addNode(const NodeRecord &record)
+{
+    myBatch.nodes.push_back(record);
+    if (myBatch.nodes.size() >= BATCH_SIZE)
+        return flush();
+    return !myCancelled;
+}
+
+bool DiagramLoader::addLink(const LinkRecord &record)
+{
+    // Nodes of a partly filled batch must reach the scene before links
+    // that refer to them; batches are applied in order, nodes first.
+    myBatch.links.push_back(record);
+    if (myBatch.nodes.size() + myBatch.links.size() >= BATCH_SIZE)
+        return flush();
+    return !myCancelled;
+}
+
+bool DiagramLoader::flush()
+{
+    {
+        QMutexLocker locker(&myMutex);
+        while (myQueue.size() >= MAX_QUEUED_BATCHES && !myCancelled)
+            myQueueNotFull.wait(&myMutex);
+        if (myCancelled)
+            return false;
+
+        myQueue.push_back(Batch());
+        myQueue.back().nodes.swap(myBatch.nodes);
+        myQueue.back().links.swap(myBatch.links);
+    }
+
+    emit batchReady();
+    return true;
+}
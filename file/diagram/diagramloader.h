@@ -0,0 +1,75 @@
+#ifndef DIAGRAMLOADER_H
+#define DIAGRAMLOADER_H
+
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include "diagramrecord.h"
+
+class DiagramReader;
+class QFile;
+
+// Reads a .diag or .diagb file on a worker thread. Records are queued in
+// batches of bounded size; batchReady() is emitted for each batch, and the
+// GUI thread collects them with takeBatch(). All node batches precede the
+// link batches. The worker blocks while too many batches are waiting, so a
+// slow consumer bounds the memory held in the queue. Text that cannot be
+// memory-mapped, such as a pipe, is parsed chunk by chunk as it arrives.
+class DiagramLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Result { Loaded, OpenFailed, ParseFailed, Cancelled };
+
+    explicit DiagramLoader(QObject *parent = 0);
+    ~DiagramLoader();
+
+    bool isBusy() const;
+    void start(const QString &fileName);
+    bool takeBatch(std::vector<NodeRecord> &nodes,
+                   std::vector<LinkRecord> &links);
+    quint64 snapshotId() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void batchReady();
+    void finished(const QString &fileName, int result);
+
+private slots:
+    void readFinished();
+
+private:
+    struct Batch
+    {
+        std::vector<NodeRecord> nodes;
+        std::vector<LinkRecord> links;
+    };
+
+    int read();
+    int readStream(QFile &file, DiagramReader &reader);
+    bool addNode(const NodeRecord &record);
+    bool addLink(const LinkRecord &record);
+    bool flush();
+
+    QFutureWatcher<int> myWatcher;
+    bool myBusy;
+    QString myFileName;
+    std::atomic<bool> myCancelled;
+    quint64 mySnapshotId;
+    Batch myBatch;
+
+    QMutex myMutex;
+    QWaitCondition myQueueNotFull;
+    std::deque<Batch> myQueue;
+};
+
+#endif
@@ -0,0 +1,303 @@
+#include <QThread>
+#include <QtConcurrent>
+
+#include "diagramparallelreader.h"
+#include "json11.hpp"
+
+namespace {
+// Below this size the structural pass and thread hand-off cost more than
+// they save.
+const size_t PARALLEL_MIN_SIZE = 1024 * 1024;
+// Approximate number of bytes of elements parsed as one task.
+const size_t RUN_SIZE = 256 * 1024;
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isDelimiter(char c)
+{
+    return isSpace(c) || c == ',' || c == ':' || c == '[' || c == ']'
+           || c == '{' || c == '}' || c == '"';
+}
+
+void skipSpace(const char *data, size_t size, size_t &pos)
+{
+    while (pos < size && isSpace(data[pos]))
+        ++pos;
+}
+
+bool skipString(const char *data, size_t size, size_t &pos)
+{
+    ++pos;
+    while (pos < size) {
+        char c = data[pos++];
+        if (c == '\\')
+            ++pos;
+        else if (c == '"')
+            return true;
+    }
+    return false;
+}
+
+// Advances pos past the value that starts there. Strings and nesting are
+// followed, but the contents are left for the parser to check.
+bool skipValue(const char *data, size_t size, size_t &pos)
+{
+    if (pos >= size)
+        return false;
+
+    char c = data[pos];
+    if (c == '"')
+        return skipString(data, size, pos);
+
+    if (c == '{' || c == '[') {
+        size_t depth = 0;
+        while (pos < size) {
+            c = data[pos];
+            if (c == '"') {
+                if (!skipString(data, size, pos))
+                    return false;
+                continue;
+            }
+            ++pos;
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    size_t start = pos;
+    while (pos < size && !isDelimiter(data[pos]))
+        ++pos;
+    return pos > start;
+}
+}
+
+DiagramParallelReader::DiagramParallelReader(
+        const DiagramReader::NodeCallback &nodeCallback,
+        const DiagramReader::LinkCallback &linkCallback)
+    : myNodeCallback(nodeCallback), myLinkCallback(linkCallback),
+      myData(0), mySize(0), myPos(0), mySnapshotId(0), myStopped(false)
+{
+}
+
+bool DiagramParallelReader::read(const char *data, size_t size,
+                                 std::string &err)
+{
+    int threads = QThread::idealThreadCount();
+    if (size < PARALLEL_MIN_SIZE || threads < 2 || !scan(data, size)) {
+        DiagramReader reader(myNodeCallback, myLinkCallback);
+        bool ok = reader.read(data, size, err);
+        mySnapshotId = reader.snapshotId();
+        return ok;
+    }
+
+    std::vector<Run *> runs;
+    for (auto &run: myNodeRuns)
+        runs.push_back(&run);
+    for (auto &run: myLinkRuns)
+        runs.push_back(&run);
+
+    // Keep a bounded number of runs ahead of delivery, so a slow consumer
+    // does not leave the whole document parsed in memory.
+    size_t window = 2 * threads;
+    std::vector<QFuture<void> > futures(runs.size());
+    size_t started = 0;
+    bool ok = true;
+    myStopped = false;
+    for (size_t i = 0; i < runs.size() && ok; ++i) {
+        for (; started < runs.size() && started < i + window; ++started)
+            futures[started] = QtConcurrent::run(
+                    this, &DiagramParallelReader::parseRun, runs[started]);
+        futures[i].waitForFinished();
+        ok = deliver(*runs[i], err);
+    }
+
+    myStopped = true;
+    for (size_t i = 0; i < started; ++i)
+        futures[i].waitForFinished();
+    myNodeRuns.clear();
+    myLinkRuns.clear();
+    return ok;
+}
+
+unsigned long long DiagramParallelReader::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+// Checks the top-level structure and records runs of whole elements of the
+// "nodes" and "links" arrays. Returns false if the document does not have
+// the expected shape; DiagramReader then reads it and reports any error.
+bool DiagramParallelReader::scan(const char *data, size_t size)
+{
+    myData = data;
+    mySize = size;
+    myPos = 0;
+    mySnapshotId = 0;
+    myNodeRuns.clear();
+    myLinkRuns.clear();
+
+    skipSpace(data, size, myPos);
+    if (myPos >= size || data[myPos] != '{')
+        return false;
+    ++myPos;
+    skipSpace(data, size, myPos);
+
+    if (myPos < size && data[myPos] == '}') {
+        ++myPos;
+    } else {
+        while (true) {
+            size_t keyStart = myPos;
+            if (myPos >= size || data[myPos] != '"'
+                    || !skipString(data, size, myPos))
+                return false;
+
+            std::string err;
+            json11::Json key = json11::Json::parse(data + keyStart,
+                                                   myPos - keyStart, err);
+            if (!err.empty())
+                return false;
+
+            skipSpace(data, size, myPos);
+            if (myPos >= size || data[myPos] != ':')
+                return false;
+            ++myPos;
+            skipSpace(data, size, myPos);
+
+            bool isNodes = key.string_value() == "nodes";
+            bool isLinks = key.string_value() == "links";
+            if ((isNodes || isLinks) && myPos < size && data[myPos] == '[') {
+                if (!scanArray(isLinks))
+                    return false;
+            } else if (key.string_value() == "snapshot") {
+                size_t valueStart = myPos;
+                if (!skipValue(data, size, myPos))
+                    return false;
+                json11::Json value = json11::Json::parse(
+                        data + valueStart, myPos - valueStart, err);
+                if (!err.empty())
+                    return false;
+                mySnapshotId = DiagramReader::parseSnapshotId(value);
+            } else {
+                size_t valueStart = myPos;
+                if (!skipValue(data, size, myPos))
+                    return false;
+                json11::JsonSax ignore;
+                if (!json11::Json::parse_sax(data + valueStart,
+                                             myPos - valueStart, ignore, err))
+                    return false;
+            }
+
+            skipSpace(data, size, myPos);
+            if (myPos < size && data[myPos] == ',') {
+                ++myPos;
+                skipSpace(data, size, myPos);
+            } else if (myPos < size && data[myPos] == '}') {
+                ++myPos;
+                break;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    skipSpace(data, size, myPos);
+    return myPos == size;
+}
+
+bool DiagramParallelReader::scanArray(bool isLink)
+{
+    std::vector<Run> &runs = isLink ? myLinkRuns : myNodeRuns;
+
+    ++myPos;
+    skipSpace(myData, mySize, myPos);
+    if (myPos < mySize && myData[myPos] == ']') {
+        ++myPos;
+        return true;
+    }
+
+    size_t runBegin = myPos;
+    while (true) {
+        if (!skipValue(myData, mySize, myPos))
+            return false;
+        size_t elementEnd = myPos;
+
+        skipSpace(myData, mySize, myPos);
+        if (myPos >= mySize
+                || (myData[myPos] != ',' && myData[myPos] != ']'))
+            return false;
+        bool last = myData[myPos] == ']';
+        ++myPos;
+        skipSpace(myData, mySize, myPos);
+
+        if (last || elementEnd - runBegin >= RUN_SIZE) {
+            Run run;
+            run.isLink = isLink;
+            run.begin = runBegin;
+            run.end = elementEnd;
+            run.ok = true;
+            runs.push_back(run);
+            runBegin = myPos;
+        }
+        if (last)
+            return true;
+    }
+}
+
+// Runs on a pool thread. The run is parsed as an array of its own, which
+// costs one copy but keeps the per-element work that of DiagramReader.
+void DiagramParallelReader::parseRun(Run *run)
+{
+    if (myStopped)
+        return;
+
+    DiagramReader reader(
+        [run](const NodeRecord &record) {
+            run->nodes.push_back(record);
+            return true;
+        },
+        [run](const LinkRecord &record) {
+            run->links.push_back(record);
+            return true;
+        });
+
+    std::string text;
+    text.reserve(run->end - run->begin + 2);
+    text += '[';
+    text.append(myData + run->begin, run->end - run->begin);
+    text += ']';
+    run->ok = reader.readArray(run->isLink, text.data(), text.size(),
+                               run->err);
+}
+
+bool DiagramParallelReader::deliver(Run &run, std::string &err)
+{
+    if (!run.ok) {
+        err = run.err;
+        return false;
+    }
+
+    for (const auto &node: run.nodes) {
+        if (!myNodeCallback(node)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+    for (const auto &link: run.links) {
+        if (!myLinkCallback(link)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+
+    std::vector<NodeRecord>().swap(run.nodes);
+    std::vector<LinkRecord>().swap(run.links);
+    return true;
+}
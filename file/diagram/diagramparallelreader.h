@@ -0,0 +1,54 @@
+#ifndef DIAGRAMPARALLELREADER_H
+#define DIAGRAMPARALLELREADER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "diagramreader.h"
+#include "diagramrecord.h"
+
+// Reads a complete .diag text using all cores. A single structural pass
+// finds the "nodes" and "links" arrays of the top-level object and cuts
+// them into runs of whole elements; the runs are parsed concurrently into
+// per-run record buffers and handed to the callbacks in document order,
+// nodes before links, exactly as DiagramReader would. Documents of any
+// other shape, and small ones, are read by DiagramReader itself.
+class DiagramParallelReader
+{
+public:
+    DiagramParallelReader(const DiagramReader::NodeCallback &nodeCallback,
+                          const DiagramReader::LinkCallback &linkCallback);
+
+    bool read(const char *data, size_t size, std::string &err);
+    unsigned long long snapshotId() const;
+
+private:
+    struct Run
+    {
+        bool isLink;
+        size_t begin;
+        size_t end;
+        bool ok;
+        std::string err;
+        std::vector<NodeRecord> nodes;
+        std::vector<LinkRecord> links;
+    };
+
+    bool scan(const char *data, size_t size);
+    bool scanArray(bool isLink);
+    void parseRun(Run *run);
+    bool deliver(Run &run, std::string &err);
+
+    DiagramReader::NodeCallback myNodeCallback;
+    DiagramReader::LinkCallback myLinkCallback;
+
+    const char *myData;
+    size_t mySize;
+    size_t myPos;
+    unsigned long long mySnapshotId;
+    std::vector<Run> myNodeRuns;
+    std::vector<Run> myLinkRuns;
+    std::atomic<bool> myStopped;
+};
+
+#endif
@@ -0,0 +1,370 @@
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+#include "diagramreader.h"
+
+namespace {
+// Depth of the values inside a "nodes"/"links" element object.
+const int ELEMENT_DEPTH = 3;
+
+unsigned fieldBit(int field)
+{
+    return 1u << field;
+}
+}
+
+DiagramReader::DiagramReader(const NodeCallback &nodeCallback,
+                             const LinkCallback &linkCallback)
+    : myNodeCallback(nodeCallback), myLinkCallback(linkCallback)
+{
+    reset();
+}
+
+void DiagramReader::reset()
+{
+    myDepth = 0;
+    myTopIsObject = false;
+    mySnapshotKey = false;
+    mySnapshotId = 0;
+    myPendingSection = NoSection;
+    mySection = NoSection;
+    myInElement = false;
+    myField = NoField;
+    myFieldsSeen = 0;
+    myLinks.clear();
+    myPushParser.reset();
+}
+
+bool DiagramReader::read(const std::string &str, std::string &err)
+{
+    return read(str.data(), str.size(), err);
+}
+
+bool DiagramReader::read(const char *data, size_t size, std::string &err)
+{
+    reset();
+    if (!json11::Json::parse_sax(data, size, *this, err))
+        return false;
+
+    return deliverLinks(err);
+}
+
+bool DiagramReader::readChunk(const char *data, size_t size, std::string &err)
+{
+    if (!myPushParser) {
+        reset();
+        myPushParser.reset(new json11::JsonPushParser(ELEMENT_DEPTH - 1));
+    }
+
+    if (!myPushParser->feed(data, size, err))
+        return false;
+    return takeElements(err);
+}
+
+bool DiagramReader::finish(std::string &err)
+{
+    if (!myPushParser)
+        myPushParser.reset(new json11::JsonPushParser(ELEMENT_DEPTH - 1));
+
+    bool ok = myPushParser->finish(err) && takeElements(err)
+              && deliverLinks(err);
+    myPushParser.reset();
+    return ok;
+}
+
+unsigned long long DiagramReader::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+// The id is written as 16 hex digits; anything else counts as no id.
+unsigned long long DiagramReader::parseSnapshotId(const json11::Json &value)
+{
+    const std::string &text = value.string_value();
+    if (text.size() != 16)
+        return 0;
+    char *end = 0;
+    unsigned long long id = std::strtoull(text.c_str(), &end, 16);
+    return *end == '\0' ? id : 0;
+}
+
+bool DiagramReader::readArray(bool isLink, const char *data, size_t size,
+                              std::string &err)
+{
+    reset();
+    myDepth = 1;
+    myTopIsObject = true;
+    myPendingSection = isLink ? LinksSection : NodesSection;
+    if (!json11::Json::parse_sax(data, size, *this, err))
+        return false;
+
+    return deliverLinks(err);
+}
+
+// Elements of the "nodes" and "links" arrays, as the push parser completes
+// them; the checks match finishElement().
+bool DiagramReader::takeElements(std::string &err)
+{
+    json11::Json element;
+    std::vector<json11::Json> path;
+    while (myPushParser->next(element, path)) {
+        if (!readElement(path, element)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only members of the top-level object count, as in the event-driven path:
+// the "snapshot" string and the elements of the "nodes" and "links" arrays.
+bool DiagramReader::readElement(const std::vector<json11::Json> &path,
+                                const json11::Json &element)
+{
+    std::string section;
+    if (!path.empty() && path[0].is_string())
+        section = path[0].string_value();
+    bool inArray = path.size() == 2 && path[1].is_null();
+
+    if (path.size() == 1 && section == "snapshot" && element.is_string()) {
+        mySnapshotId = parseSnapshotId(element);
+    } else if (inArray && section == "nodes") {
+        if (!element["index"].is_number()) {
+            std::cerr << "invalid json of node, no index property\n";
+            return true;
+        }
+        if (!element["text"].is_string()) {
+            std::cerr << "invalid json of node, no string property\n";
+            return true;
+        }
+        if (!element["x"].is_number()) {
+            std::cerr << "invalid json of node, no x property\n";
+            return true;
+        }
+        if (!element["y"].is_number()) {
+            std::cerr << "invalid json of node, no y property\n";
+            return true;
+        }
+
+        NodeRecord node;
+        node.index = element["index"].int_value();
+        node.text = element["text"].string_value();
+        node.x = element["x"].int_value();
+        node.y = element["y"].int_value();
+        node.hasColors = false;
+        return myNodeCallback(node);
+    } else if (inArray && section == "links") {
+        if (!element["from"].is_number()) {
+            std::cerr << "invalid json of link, no from property\n";
+            return true;
+        }
+        if (!element["to"].is_number()) {
+            std::cerr << "invalid json of link, no to property\n";
+            return true;
+        }
+
+        LinkRecord link;
+        link.from = element["from"].int_value();
+        link.to = element["to"].int_value();
+        link.color = 0;
+        myLinks.push_back(link);
+    }
+    return true;
+}
+
+bool DiagramReader::deliverLinks(std::string &err)
+{
+    for (const auto &link: myLinks) {
+        if (!myLinkCallback(link)) {
+            err = "reading aborted";
+            return false;
+        }
+    }
+    myLinks.clear();
+
+    return true;
+}
+
+bool DiagramReader::null_value()
+{
+    scalarValue();
+    return true;
+}
+
+bool DiagramReader::bool_value(bool)
+{
+    scalarValue();
+    return true;
+}
+
+bool DiagramReader::number_value(double value)
+{
+    if (myInElement && myDepth == ELEMENT_DEPTH) {
+        int number = static_cast<int>(value);
+        switch (myField) {
+        case IndexField: myNode.index = number; break;
+        case XField: myNode.x = number; break;
+        case YField: myNode.y = number; break;
+        case FromField: myLink.from = number; break;
+        case ToField: myLink.to = number; break;
+        default: scalarValue(); return true;
+        }
+        myFieldsSeen |= fieldBit(myField);
+        return true;
+    }
+
+    scalarValue();
+    return true;
+}
+
+bool DiagramReader::string_value(std::string &&value)
+{
+    if (myDepth == 1 && mySnapshotKey) {
+        mySnapshotId = parseSnapshotId(json11::Json(std::move(value)));
+        return true;
+    }
+    if (myInElement && myDepth == ELEMENT_DEPTH && myField == TextField) {
+        myNode.text = std::move(value);
+        myFieldsSeen |= fieldBit(TextField);
+        return true;
+    }
+
+    scalarValue();
+    return true;
+}
+
+bool DiagramReader::start_array()
+{
+    if (myDepth == 1 && myTopIsObject) {
+        mySection = myPendingSection;
+    } else if (myDepth == 2 && mySection != NoSection) {
+        invalidElement();
+    } else if (myDepth == ELEMENT_DEPTH && myInElement) {
+        myFieldsSeen &= ~fieldBit(myField);
+    }
+
+    ++myDepth;
+    return true;
+}
+
+bool DiagramReader::end_array()
+{
+    --myDepth;
+    if (myDepth == 1)
+        mySection = NoSection;
+    return true;
+}
+
+bool DiagramReader::start_object()
+{
+    if (myDepth == 0) {
+        myTopIsObject = true;
+    } else if (myDepth == 2 && mySection != NoSection) {
+        beginElement();
+    } else if (myDepth == ELEMENT_DEPTH && myInElement) {
+        myFieldsSeen &= ~fieldBit(myField);
+    }
+
+    ++myDepth;
+    return true;
+}
+
+bool DiagramReader::key(std::string &&key)
+{
+    if (myDepth == 1) {
+        mySnapshotKey = (key == "snapshot");
+        if (key == "nodes")
+            myPendingSection = NodesSection;
+        else if (key == "links")
+            myPendingSection = LinksSection;
+        else
+            myPendingSection = NoSection;
+    } else if (myDepth == ELEMENT_DEPTH && myInElement) {
+        myField = NoField;
+        if (mySection == NodesSection) {
+            if (key == "index")
+                myField = IndexField;
+            else if (key == "text")
+                myField = TextField;
+            else if (key == "x")
+                myField = XField;
+            else if (key == "y")
+                myField = YField;
+        } else {
+            if (key == "from")
+                myField = FromField;
+            else if (key == "to")
+                myField = ToField;
+        }
+    }
+    return true;
+}
+
+bool DiagramReader::end_object()
+{
+    --myDepth;
+    if (myDepth == 2 && myInElement)
+        return finishElement();
+    return true;
+}
+
+void DiagramReader::scalarValue()
+{
+    if (myDepth == 2 && mySection != NoSection)
+        invalidElement();
+    else if (myDepth == ELEMENT_DEPTH && myInElement)
+        myFieldsSeen &= ~fieldBit(myField);
+}
+
+void DiagramReader::beginElement()
+{
+    myNode.hasColors = false;
+    myInElement = true;
+    myField = NoField;
+    myFieldsSeen = 0;
+}
+
+void DiagramReader::invalidElement()
+{
+    if (mySection == NodesSection)
+        std::cerr << "invalid json of node, no index property\n";
+    else
+        std::cerr << "invalid json of link, no from property\n";
+}
+
+bool DiagramReader::finishElement()
+{
+    myInElement = false;
+
+    if (mySection == NodesSection) {
+        if (!(myFieldsSeen & fieldBit(IndexField))) {
+            std::cerr << "invalid json of node, no index property\n";
+            return true;
+        }
+        if (!(myFieldsSeen & fieldBit(TextField))) {
+            std::cerr << "invalid json of node, no string property\n";
+            return true;
+        }
+        if (!(myFieldsSeen & fieldBit(XField))) {
+            std::cerr << "invalid json of node, no x property\n";
+            return true;
+        }
+        if (!(myFieldsSeen & fieldBit(YField))) {
+            std::cerr << "invalid json of node, no y property\n";
+            return true;
+        }
+        return myNodeCallback(myNode);
+    } else {
+        if (!(myFieldsSeen & fieldBit(FromField))) {
+            std::cerr << "invalid json of link, no from property\n";
+            return true;
+        }
+        if (!(myFieldsSeen & fieldBit(ToField))) {
+            std::cerr << "invalid json of link, no to property\n";
+            return true;
+        }
+        myLinks.push_back(myLink);
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef DIAGRAMREADER_H
+#define DIAGRAMREADER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "diagramrecord.h"
+#include "json11.hpp"
+
+// Event-driven reader for .diag files. Node and link records are handed to
+// the callbacks as soon as they are complete; no json11::Json tree is built.
+// A callback returns false to stop reading.
+// Links are delivered after all nodes, because .diag files list "links"
+// before "nodes" (json11 writes object keys in sorted order). A file
+// written by DiagramWriter ends with a "snapshot" id, which is available
+// from snapshotId() once the whole text has been read.
+class DiagramReader : private json11::JsonSax
+{
+public:
+    typedef std::function<bool(const NodeRecord &)> NodeCallback;
+    typedef std::function<bool(const LinkRecord &)> LinkCallback;
+
+    DiagramReader(const NodeCallback &nodeCallback,
+                  const LinkCallback &linkCallback);
+
+    bool read(const std::string &str, std::string &err);
+    bool read(const char *data, size_t size, std::string &err);
+
+    // Incremental reading, for input that arrives in pieces: pass each
+    // chunk to readChunk() as it comes, then call finish(). Nodes are
+    // delivered while the input is still arriving.
+    bool readChunk(const char *data, size_t size, std::string &err);
+    bool finish(std::string &err);
+
+    // Reads a JSON array of elements of the "nodes" (or, if isLink, the
+    // "links") array on its own, for callers that split a document
+    // themselves. Links are delivered at the end of the call.
+    bool readArray(bool isLink, const char *data, size_t size,
+                   std::string &err);
+
+    // Zero if the text has no snapshot id.
+    unsigned long long snapshotId() const;
+    static unsigned long long parseSnapshotId(const json11::Json &value);
+
+private:
+    enum Section { NoSection, NodesSection, LinksSection };
+    enum Field { NoField, IndexField, TextField, XField, YField,
+                 FromField, ToField };
+
+    bool null_value();
+    bool bool_value(bool value);
+    bool number_value(double value);
+    bool string_value(std::string &&value);
+    bool start_array();
+    bool end_array();
+    bool start_object();
+    bool key(std::string &&key);
+    bool end_object();
+
+    void reset();
+    bool takeElements(std::string &err);
+    bool readElement(const std::vector<json11::Json> &path,
+                     const json11::Json &element);
+    bool deliverLinks(std::string &err);
+    void beginElement();
+    bool finishElement();
+    void invalidElement();
+    void scalarValue();
+
+    NodeCallback myNodeCallback;
+    LinkCallback myLinkCallback;
+
+    int myDepth;
+    bool myTopIsObject;
+    bool mySnapshotKey;
+    unsigned long long mySnapshotId;
+    Section myPendingSection;
+    Section mySection;
+    bool myInElement;
+    Field myField;
+    unsigned myFieldsSeen;
+    NodeRecord myNode;
+    LinkRecord myLink;
+    std::vector<LinkRecord> myLinks;
+    std::unique_ptr<json11::JsonPushParser> myPushParser;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef DIAGRAMRECORD_H
+#define DIAGRAMRECORD_H
+
+#include <string>
+
+// Plain node state as read from or written to a diagram file. Colors are
+// 0xAARRGGBB values and are only meaningful when hasColors is set; .diag
+// files do not store them.
+struct NodeRecord
+{
+    int index;
+    std::string text;
+    int x;
+    int y;
+    bool hasColors;
+    unsigned int textColor;
+    unsigned int outlineColor;
+    unsigned int backgroundColor;
+};
+
+// Plain link state; endpoints refer to NodeRecord::index. The color is an
+// 0xAARRGGBB value, or zero for the default color; .diag files do not
+// store it.
+struct LinkRecord
+{
+    int from;
+    int to;
+    unsigned int color;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include "diagrambinary.h"
+#include "diagramjournal.h"
+#include "diagramsaver.h"
+#include "diagramtiles.h"
+#include "diagramwriter.h"
+
+DiagramSaver::DiagramSaver(QObject *parent)
+    : QObject(parent), myBusy(false), myOk(true), myPercent(0),
+      mySnapshotId(0)
+{
+    connect(&myWatcher, SIGNAL(finished()), this, SLOT(writeFinished()));
+}
+
+bool DiagramSaver::isBusy() const
+{
+    return myBusy;
+}
+
+// Takes over the contents of snapshot; the worker owns them until
+// finished() is emitted.
+void DiagramSaver::start(const QString &fileName,
+                         DiagramStore::Snapshot &snapshot,
+                         quint64 snapshotId)
+{
+    waitForFinished();
+
+    myFileName = fileName;
+    mySnapshotId = snapshotId;
+    std::swap(mySnapshot, snapshot);
+    myPercent = 0;
+    myBusy = true;
+    myWatcher.setFuture(QtConcurrent::run(this, &DiagramSaver::write));
+}
+
+// Returns whether the last write succeeded; true if there has been none.
+bool DiagramSaver::waitForFinished()
+{
+    if (myBusy) {
+        myWatcher.waitForFinished();
+        writeFinished();
+    }
+    return myOk;
+}
+
+// The id of the snapshot last started.
+quint64 DiagramSaver::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+void DiagramSaver::writeFinished()
+{
+    if (!myBusy)
+        return;
+
+    myBusy = false;
+    myOk = myWatcher.result();
+    mySnapshot = DiagramStore::Snapshot();
+    emit finished(myFileName, myOk);
+}
+
+// Runs on the worker thread. A snapshot that cannot be read in full is not
+// written.
+bool DiagramSaver::write()
+{
+    if (!mySnapshot.readFile())
+        return false;
+
+    const std::vector<NodeRecord> &nodes = mySnapshot.nodes;
+    const std::vector<LinkRecord> &links = mySnapshot.links;
+    QSaveFile file(myFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    bool ok;
+    if (myFileName.endsWith(".diagb", Qt::CaseInsensitive)) {
+        ok = DiagramBinaryWriter::write(&file, nodes, links, mySnapshotId);
+    } else if (myFileName.endsWith(".diagt", Qt::CaseInsensitive)) {
+        ok = DiagramTileWriter::write(&file, nodes, links, mySnapshotId);
+    } else {
+        ok = writeJson(&file);
+    }
+
+    if (!ok) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit())
+        return false;
+
+    DiagramJournal(myFileName, mySnapshotId).remove();
+    emit progress(100);
+    return true;
+}
+
+bool DiagramSaver::writeJson(QIODevice *device)
+{
+    DiagramWriter writer(device);
+    return writer.write(mySnapshot.nodes, mySnapshot.links, mySnapshotId,
+                        [this](size_t done, size_t total) {
+                            reportProgress(done, total);
+                        });
+}
+
+// The last percent is reported once the file has been committed.
+void DiagramSaver::reportProgress(size_t done, size_t total)
+{
+    int percent = int(99 * done / total);
+    if (percent != myPercent) {
+        myPercent = percent;
+        emit progress(percent);
+    }
+}
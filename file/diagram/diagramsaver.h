@@ -0,0 +1,51 @@
+#ifndef DIAGRAMSAVER_H
+#define DIAGRAMSAVER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <vector>
+#include "diagramstore.h"
+
+class QIODevice;
+
+// Writes a snapshot of a diagram on a worker thread, which also reads the
+// records the snapshot has left in a tiled file. The file is written to
+// a temporary file that replaces the target only once it is complete, and a
+// journal left next to the target is removed afterwards. The snapshot id is
+// stored in the file, so that a journal can tell which snapshot it extends.
+class DiagramSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DiagramSaver(QObject *parent = 0);
+
+    bool isBusy() const;
+    void start(const QString &fileName, DiagramStore::Snapshot &snapshot,
+               quint64 snapshotId);
+    bool waitForFinished();
+    quint64 snapshotId() const;
+
+signals:
+    void progress(int percent);
+    void finished(const QString &fileName, bool ok);
+
+private slots:
+    void writeFinished();
+
+private:
+    bool write();
+    bool writeJson(QIODevice *device);
+    void reportProgress(size_t done, size_t total);
+
+    QFutureWatcher<bool> myWatcher;
+    bool myBusy;
+    bool myOk;
+    int myPercent;
+    QString myFileName;
+    quint64 mySnapshotId;
+    DiagramStore::Snapshot mySnapshot;
+};
+
+#endif
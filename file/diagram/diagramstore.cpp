@@ -0,0 +1,465 @@
+#include <algorithm>
+
+#include "diagramstore.h"
+#include "diagramtiles.h"
+
+namespace {
+const std::vector<int> NO_LINKS;
+}
+
+DiagramStore::DiagramStore()
+    : myTileSize(DiagramTileWriter::TILE_SIZE), myMaxIndex(0)
+{
+}
+
+// Replaces the contents of the store with a .diagt file. Only the file's
+// directory is read here.
+bool DiagramStore::open(const QString &fileName, std::string &err)
+{
+    clear();
+    std::shared_ptr<DiagramTileFile> file(new DiagramTileFile);
+    if (!file->open(fileName, err))
+        return false;
+
+    myFile = file;
+    myTileSize = file->tileSize();
+    myMaxIndex = file->maxIndex();
+    for (int i = 0; i < file->tileCount(); ++i) {
+        QRect rect = file->tileRect(i);
+        TileKey key(rect.x() / myTileSize, rect.y() / myTileSize);
+        myTiles[key].fileTile = i;
+    }
+
+    StoredLink unread = { { 0, 0, 0 }, UnreadLink };
+    myLinks.assign(file->linkCount(), unread);
+    return true;
+}
+
+void DiagramStore::clear()
+{
+    myFile.reset();
+    myTileSize = DiagramTileWriter::TILE_SIZE;
+    myMaxIndex = 0;
+    myTiles.clear();
+    myPlaceOfNode.clear();
+    myLinks.clear();
+    myLinksOfNode.clear();
+}
+
+// Reads every tile that is still in the file. Returns false if any of them
+// could not be read.
+bool DiagramStore::readAll()
+{
+    bool ok = true;
+    for (auto &entry: myTiles) {
+        if (!readTile(entry.second))
+            ok = false;
+    }
+    return ok;
+}
+
+int DiagramStore::tileSize() const
+{
+    return myTileSize;
+}
+
+int DiagramStore::maxIndex() const
+{
+    return myMaxIndex;
+}
+
+// The id of the .diagt file the store was opened on, if it has one.
+quint64 DiagramStore::snapshotId() const
+{
+    return myFile ? myFile->snapshotId() : 0;
+}
+
+QRect DiagramStore::bounds() const
+{
+    QRect rect;
+    for (const auto &entry: myTiles)
+        rect |= tileRect(entry.first);
+    return rect;
+}
+
+QRect DiagramStore::tileRect(const TileKey &tile) const
+{
+    return QRect(tile.first * myTileSize, tile.second * myTileSize,
+                 myTileSize, myTileSize);
+}
+
+DiagramStore::TileKey DiagramStore::tileAt(int x, int y) const
+{
+    return TileKey(DiagramTiles::tileCoordinate(x, myTileSize),
+                   DiagramTiles::tileCoordinate(y, myTileSize));
+}
+
+std::vector<DiagramStore::TileKey> DiagramStore::tiles() const
+{
+    std::vector<TileKey> keys;
+    keys.reserve(myTiles.size());
+    for (const auto &entry: myTiles)
+        keys.push_back(entry.first);
+    return keys;
+}
+
+void DiagramStore::addNode(const NodeRecord &record)
+{
+    Tile &tile = myTiles[tileAt(record.x, record.y)];
+    readTile(tile);
+    NodePlace place = { &tile, int(tile.nodes.size()), false };
+    tile.nodes.push_back(record);
+    myPlaceOfNode[record.index] = place;
+    if (myMaxIndex < record.index)
+        myMaxIndex = record.index;
+}
+
+void DiagramStore::moveNode(int index, int x, int y)
+{
+    NodeRecord record;
+    if (!takeStored(index, record))
+        return;
+    record.x = x;
+    record.y = y;
+    addNode(record);
+}
+
+void DiagramStore::renameNode(int index, const std::string &text)
+{
+    NodeRecord *record = findStored(index);
+    if (record)
+        record->text = text;
+}
+
+void DiagramStore::recolorNode(const NodeRecord &record)
+{
+    NodeRecord *stored = findStored(record.index);
+    if (stored) {
+        stored->hasColors = true;
+        stored->textColor = record.textColor;
+        stored->outlineColor = record.outlineColor;
+        stored->backgroundColor = record.backgroundColor;
+    }
+}
+
+void DiagramStore::removeNode(int index)
+{
+    NodeRecord record;
+    if (!takeStored(index, record))
+        detachLive(index);
+
+    auto iter = myLinksOfNode.find(index);
+    if (iter == myLinksOfNode.end())
+        return;
+    std::vector<int> ids;
+    ids.swap(iter->second);
+    myLinksOfNode.erase(iter);
+    for (int id: ids)
+        removeLink(id);
+}
+
+// Copies the record of a stored node. Returns false for live nodes and
+// nodes the store does not have.
+bool DiagramStore::storedNode(int index, NodeRecord &record)
+{
+    NodeRecord *stored = findStored(index);
+    if (!stored)
+        return false;
+    record = *stored;
+    return true;
+}
+
+// Returns the id of the new link, or -1 if either endpoint is not in the
+// store.
+int DiagramStore::addLink(const LinkRecord &record)
+{
+    if (!myPlaceOfNode.count(record.from) || !myPlaceOfNode.count(record.to))
+        return -1;
+
+    int id = myLinks.size();
+    StoredLink link = { record, PresentLink };
+    myLinks.push_back(link);
+    myLinksOfNode[record.from].push_back(id);
+    if (record.to != record.from)
+        myLinksOfNode[record.to].push_back(id);
+    return id;
+}
+
+void DiagramStore::removeLink(int id)
+{
+    if (id < 0 || id >= int(myLinks.size())
+            || myLinks[id].state != PresentLink)
+        return;
+
+    StoredLink &link = myLinks[id];
+    link.state = RemovedLink;
+    forgetLinkOf(link.record.from, id);
+    forgetLinkOf(link.record.to, id);
+}
+
+// Removes one link from record.from to record.to, if there is one.
+bool DiagramStore::removeLink(const LinkRecord &record)
+{
+    int id = findLink(record);
+    if (id < 0)
+        return false;
+    removeLink(id);
+    return true;
+}
+
+// Gives one link from record.from to record.to the color of record, if
+// there is such a link.
+bool DiagramStore::recolorLink(const LinkRecord &record)
+{
+    int id = findLink(record);
+    if (id < 0)
+        return false;
+    myLinks[id].record.color = record.color;
+    return true;
+}
+
+// False for links that have been removed, either on their own or with one
+// of their endpoints.
+bool DiagramStore::isLinkPresent(int id) const
+{
+    return id >= 0 && id < int(myLinks.size())
+           && myLinks[id].state == PresentLink;
+}
+
+// The record of a removed link is kept.
+const LinkRecord &DiagramStore::linkRecord(int id) const
+{
+    return myLinks[id].record;
+}
+
+// Zero if the link has the default color.
+unsigned int DiagramStore::linkColor(int id) const
+{
+    return myLinks[id].record.color;
+}
+
+void DiagramStore::setLinkColor(int id, unsigned int color)
+{
+    if (id >= 0 && id < int(myLinks.size()))
+        myLinks[id].record.color = color;
+}
+
+// The ids of the links of a node whose tile has been read.
+const std::vector<int> &DiagramStore::linksOf(int index) const
+{
+    auto iter = myLinksOfNode.find(index);
+    return iter == myLinksOfNode.end() ? NO_LINKS : iter->second;
+}
+
+bool DiagramStore::isLive(const TileKey &tile) const
+{
+    auto iter = myTiles.find(tile);
+    return iter != myTiles.end() && iter->second.live;
+}
+
+// Hands out the records of a tile that is not live, and makes the tile
+// live with those nodes. Returns false if the tile could not be read from
+// the file; whatever could be read is handed out all the same.
+bool DiagramStore::makeLive(const TileKey &tile,
+                            std::vector<NodeRecord> &nodes)
+{
+    Tile &entry = myTiles[tile];
+    bool ok = readTile(entry);
+
+    nodes.clear();
+    nodes.swap(entry.nodes);
+    entry.live = true;
+    for (const auto &record: nodes) {
+        NodePlace place = { &entry, int(entry.liveNodes.size()), true };
+        entry.liveNodes.push_back(record.index);
+        myPlaceOfNode[record.index] = place;
+    }
+    return ok;
+}
+
+std::vector<int> DiagramStore::liveNodes(const TileKey &tile) const
+{
+    auto iter = myTiles.find(tile);
+    return iter == myTiles.end() ? std::vector<int>()
+                                 : iter->second.liveNodes;
+}
+
+// Makes a live node part of a live tile: a node that has just been
+// created, or one that has been moved out of the tile it was part of.
+void DiagramStore::attachNode(int index, const TileKey &tile)
+{
+    detachLive(index);
+    Tile &entry = myTiles[tile];
+    NodePlace place = { &entry, int(entry.liveNodes.size()), true };
+    entry.liveNodes.push_back(index);
+    myPlaceOfNode[index] = place;
+    if (myMaxIndex < index)
+        myMaxIndex = index;
+}
+
+// Takes back the record of a live node whose item is going away. The
+// record goes to the tile that contains its position: the tile being
+// evicted, or one that has no items.
+void DiagramStore::storeNode(const NodeRecord &record)
+{
+    detachLive(record.index);
+    addNode(record);
+}
+
+// Ends the live state of a tile once all of its nodes have been stored or
+// attached to other tiles; any node left in it is forgotten.
+void DiagramStore::release(const TileKey &tile)
+{
+    Tile &entry = myTiles[tile];
+    entry.live = false;
+    for (int index: entry.liveNodes)
+        myPlaceOfNode.erase(index);
+    entry.liveNodes.clear();
+}
+
+// Copies the records of every stored node and of every link the store has
+// read, and notes which tiles and links are still in the file. The
+// records of live nodes are for the caller to add.
+void DiagramStore::snapshot(Snapshot &snapshot) const
+{
+    snapshot = Snapshot();
+    for (const auto &entry: myTiles) {
+        const Tile &tile = entry.second;
+        snapshot.nodes.insert(snapshot.nodes.end(), tile.nodes.begin(),
+                              tile.nodes.end());
+        if (tile.fileTile >= 0)
+            snapshot.fileTiles.push_back(tile.fileTile);
+    }
+
+    snapshot.unreadLinks.assign(myLinks.size(), false);
+    for (size_t id = 0; id < myLinks.size(); ++id) {
+        if (myLinks[id].state == PresentLink)
+            snapshot.links.push_back(myLinks[id].record);
+        else if (myLinks[id].state == UnreadLink)
+            snapshot.unreadLinks[id] = true;
+    }
+    if (!snapshot.fileTiles.empty())
+        snapshot.file = myFile;
+}
+
+// Adds the records of the tiles and links left in the file. A link is in
+// the tiles of both of its endpoints and is taken once. Returns false if a
+// tile could not be read.
+bool DiagramStore::Snapshot::readFile()
+{
+    bool ok = true;
+    std::vector<DiagramTileFile::TileLink> tileLinks;
+    for (int tile: fileTiles) {
+        tileLinks.clear();
+        if (!file->readTile(tile, nodes, tileLinks))
+            ok = false;
+        for (const auto &entry: tileLinks) {
+            if (entry.id >= 0 && entry.id < int(unreadLinks.size())
+                    && unreadLinks[entry.id]) {
+                unreadLinks[entry.id] = false;
+                links.push_back(entry.record);
+            }
+        }
+    }
+    fileTiles.clear();
+    file.reset();
+    return ok;
+}
+
+// Moves the records of a tile from the file into the store. A link is in
+// the tiles of both of its endpoints, and is taken from whichever of them
+// is read first.
+bool DiagramStore::readTile(Tile &tile)
+{
+    if (tile.fileTile < 0)
+        return true;
+
+    std::vector<DiagramTileFile::TileLink> links;
+    size_t first = tile.nodes.size();
+    bool ok = myFile->readTile(tile.fileTile, tile.nodes, links);
+    tile.fileTile = -1;
+
+    for (size_t i = first; i < tile.nodes.size(); ++i) {
+        NodePlace place = { &tile, int(i), false };
+        myPlaceOfNode[tile.nodes[i].index] = place;
+    }
+
+    for (const auto &entry: links) {
+        if (entry.id < 0 || entry.id >= int(myLinks.size())
+                || myLinks[entry.id].state != UnreadLink)
+            continue;
+
+        StoredLink &link = myLinks[entry.id];
+        link.record = entry.record;
+        link.state = PresentLink;
+        myLinksOfNode[link.record.from].push_back(entry.id);
+        if (link.record.to != link.record.from)
+            myLinksOfNode[link.record.to].push_back(entry.id);
+    }
+    return ok;
+}
+
+NodeRecord *DiagramStore::findStored(int index)
+{
+    auto iter = myPlaceOfNode.find(index);
+    if (iter == myPlaceOfNode.end() || iter->second.live)
+        return 0;
+    return &iter->second.tile->nodes[iter->second.slot];
+}
+
+// The last record of the tile takes the place of the one taken.
+bool DiagramStore::takeStored(int index, NodeRecord &record)
+{
+    auto iter = myPlaceOfNode.find(index);
+    if (iter == myPlaceOfNode.end() || iter->second.live)
+        return false;
+
+    std::vector<NodeRecord> &nodes = iter->second.tile->nodes;
+    int slot = iter->second.slot;
+    myPlaceOfNode.erase(iter);
+    record = std::move(nodes[slot]);
+    if (slot + 1 < int(nodes.size())) {
+        nodes[slot] = std::move(nodes.back());
+        myPlaceOfNode[nodes[slot].index].slot = slot;
+    }
+    nodes.pop_back();
+    return true;
+}
+
+void DiagramStore::detachLive(int index)
+{
+    auto iter = myPlaceOfNode.find(index);
+    if (iter == myPlaceOfNode.end() || !iter->second.live)
+        return;
+
+    std::vector<int> &live = iter->second.tile->liveNodes;
+    int slot = iter->second.slot;
+    myPlaceOfNode.erase(iter);
+    if (slot + 1 < int(live.size())) {
+        live[slot] = live.back();
+        myPlaceOfNode[live[slot]].slot = slot;
+    }
+    live.pop_back();
+}
+
+int DiagramStore::findLink(const LinkRecord &record) const
+{
+    for (int id: linksOf(record.from)) {
+        const LinkRecord &link = myLinks[id].record;
+        if (link.from == record.from && link.to == record.to)
+            return id;
+    }
+    return -1;
+}
+
+void DiagramStore::forgetLinkOf(int index, int id)
+{
+    auto iter = myLinksOfNode.find(index);
+    if (iter == myLinksOfNode.end())
+        return;
+
+    std::vector<int> &ids = iter->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty())
+        myLinksOfNode.erase(iter);
+}
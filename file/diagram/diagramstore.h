@@ -0,0 +1,130 @@
+#ifndef DIAGRAMSTORE_H
+#define DIAGRAMSTORE_H
+
+#include <QRect>
+#include <QString>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "diagramrecord.h"
+
+class DiagramTileFile;
+
+// The whole graph of a document as plain records: nodes bucketed by the
+// square scene tile that contains their position, and links in one table
+// under ids that stay fixed. The window makes the tiles near the viewport
+// live; it takes their records to create items from, and the items are
+// the state of those nodes until the tile is evicted and their records are
+// handed back. A store opened on a .diagt file leaves the records of a
+// tile in the file until the tile is first needed.
+class DiagramStore
+{
+public:
+    typedef std::pair<int, int> TileKey;
+
+    // The records of the store at one moment. Tiles and links that are
+    // still in the store's file stay there until readFile(), which does not
+    // touch the store and may run on another thread. They are unchanged
+    // since the file was opened, as the store reads a tile before any edit
+    // of its nodes or links.
+    struct Snapshot
+    {
+        std::vector<NodeRecord> nodes;
+        std::vector<LinkRecord> links;
+        std::shared_ptr<const DiagramTileFile> file;
+        std::vector<int> fileTiles;
+        std::vector<bool> unreadLinks;
+
+        bool readFile();
+    };
+
+    DiagramStore();
+
+    bool open(const QString &fileName, std::string &err);
+    void clear();
+    bool readAll();
+
+    int tileSize() const;
+    int maxIndex() const;
+    quint64 snapshotId() const;
+    QRect bounds() const;
+    QRect tileRect(const TileKey &tile) const;
+    TileKey tileAt(int x, int y) const;
+    std::vector<TileKey> tiles() const;
+
+    // Edits of stored nodes; nodes of live tiles are left alone.
+    void addNode(const NodeRecord &record);
+    void moveNode(int index, int x, int y);
+    void renameNode(int index, const std::string &text);
+    void recolorNode(const NodeRecord &record);
+
+    // Removes a stored or live node together with its links.
+    void removeNode(int index);
+    bool storedNode(int index, NodeRecord &record);
+
+    int addLink(const LinkRecord &record);
+    void removeLink(int id);
+    bool removeLink(const LinkRecord &record);
+    bool recolorLink(const LinkRecord &record);
+    bool isLinkPresent(int id) const;
+    const LinkRecord &linkRecord(int id) const;
+    unsigned int linkColor(int id) const;
+    void setLinkColor(int id, unsigned int color);
+    const std::vector<int> &linksOf(int index) const;
+
+    bool isLive(const TileKey &tile) const;
+    bool makeLive(const TileKey &tile, std::vector<NodeRecord> &nodes);
+    std::vector<int> liveNodes(const TileKey &tile) const;
+    void attachNode(int index, const TileKey &tile);
+    void storeNode(const NodeRecord &record);
+    void release(const TileKey &tile);
+
+    void snapshot(Snapshot &snapshot) const;
+
+private:
+    enum LinkState { UnreadLink, PresentLink, RemovedLink };
+
+    struct Tile
+    {
+        int fileTile;
+        bool live;
+        std::vector<NodeRecord> nodes;
+        std::vector<int> liveNodes;
+
+        Tile() : fileTile(-1), live(false) {}
+    };
+
+    // Where a node is: its slot in the nodes of its tile, or in the live
+    // nodes if it is live.
+    struct NodePlace
+    {
+        Tile *tile;
+        int slot;
+        bool live;
+    };
+
+    struct StoredLink
+    {
+        LinkRecord record;
+        LinkState state;
+    };
+
+    bool readTile(Tile &tile);
+    NodeRecord *findStored(int index);
+    bool takeStored(int index, NodeRecord &record);
+    void detachLive(int index);
+    int findLink(const LinkRecord &record) const;
+    void forgetLinkOf(int index, int id);
+
+    std::shared_ptr<DiagramTileFile> myFile;
+    int myTileSize;
+    int myMaxIndex;
+    std::map<TileKey, Tile> myTiles;
+    std::unordered_map<int, NodePlace> myPlaceOfNode;
+    std::vector<StoredLink> myLinks;
+    std::unordered_map<int, std::vector<int> > myLinksOfNode;
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include <QByteArray>
+#include <QIODevice>
+#include <QtEndian>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+#include "diagramtiles.h"
+
+namespace {
+const char MAGIC[4] = { 'D', 'I', 'A', 'T' };
+const quint32 VERSION = 2;
+const size_t HEADER_SIZE = 32;
+const size_t ENTRY_SIZE = 32;
+const size_t NODE_SIZE = 28;
+const size_t LINK_SIZE = 16;
+const size_t V1_LINK_SIZE = 12;
+
+typedef std::pair<int, int> TileKey;
+
+quint32 readU32(const char *data, size_t i)
+{
+    return qFromLittleEndian<quint32>(
+                reinterpret_cast<const uchar *>(data + 4 * i));
+}
+
+qint32 readI32(const char *data, size_t i)
+{
+    return qFromLittleEndian<qint32>(
+                reinterpret_cast<const uchar *>(data + 4 * i));
+}
+
+quint64 readU64(const char *data, size_t i)
+{
+    return qFromLittleEndian<quint64>(
+                reinterpret_cast<const uchar *>(data + 4 * i));
+}
+
+void putU32(QByteArray &out, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    out.append(reinterpret_cast<const char *>(bytes), 4);
+}
+
+void putU64(QByteArray &out, quint64 value)
+{
+    uchar bytes[8];
+    qToLittleEndian<quint64>(value, bytes);
+    out.append(reinterpret_cast<const char *>(bytes), 8);
+}
+}
+
+bool DiagramTiles::isTiled(const char *data, size_t size)
+{
+    return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+// Rounds towards negative infinity, so tiles left of or above the origin
+// get negative coordinates instead of sharing tile 0.
+int DiagramTiles::tileCoordinate(int value, int tileSize)
+{
+    return value >= 0 ? value / tileSize : -((-value - 1) / tileSize) - 1;
+}
+
+bool DiagramTiles::isTiledFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray head = file.read(sizeof(MAGIC));
+    return isTiled(head.constData(), head.size());
+}
+
+DiagramTileFile::DiagramTileFile()
+    : myData(0), mySize(0), myVersion(0), myTileSize(0), myLinkCount(0), myMaxIndex(0),
+      mySnapshotId(0)
+{
+}
+
+// Maps the file and reads its directory; tile bodies are only touched by
+// readTile().
+bool DiagramTileFile::open(const QString &fileName, std::string &err)
+{
+    myFile.setFileName(fileName);
+    if (!myFile.open(QIODevice::ReadOnly)) {
+        err = "cannot open file";
+        return false;
+    }
+    mySize = myFile.size();
+    myData = reinterpret_cast<const char *>(myFile.map(0, mySize));
+    if (!myData) {
+        err = "cannot map file";
+        return false;
+    }
+
+    if (mySize < HEADER_SIZE || !DiagramTiles::isTiled(myData, mySize)) {
+        err = "not a tiled diagram";
+        return false;
+    }
+    myVersion = readU32(myData, 1);
+    if (myVersion != 1 && myVersion != VERSION) {
+        err = "unsupported tiled diagram version";
+        return false;
+    }
+    size_t linkSize = myVersion == 1 ? V1_LINK_SIZE : LINK_SIZE;
+
+    myTileSize = readI32(myData, 2);
+    quint64 tileCount = readU32(myData, 3);
+    myLinkCount = readI32(myData, 4);
+    myMaxIndex = readI32(myData, 5);
+    mySnapshotId = readU64(myData, 6);
+    if (myTileSize <= 0 || myLinkCount < 0) {
+        err = "invalid tiled diagram header";
+        return false;
+    }
+    if (HEADER_SIZE + ENTRY_SIZE * tileCount > mySize) {
+        err = "truncated tiled diagram";
+        return false;
+    }
+
+    myTiles.resize(tileCount);
+    for (size_t i = 0; i < tileCount; ++i) {
+        const char *entry = myData + HEADER_SIZE + ENTRY_SIZE * i;
+        Tile &tile = myTiles[i];
+        tile.column = readI32(entry, 0);
+        tile.row = readI32(entry, 1);
+        tile.nodeCount = readU32(entry, 2);
+        tile.linkCount = readU32(entry, 3);
+        tile.offset = readU64(entry, 4);
+        tile.size = readU64(entry, 6);
+        if (tile.offset > mySize || tile.size > mySize - tile.offset
+                || NODE_SIZE * tile.nodeCount + linkSize * tile.linkCount
+                   > tile.size) {
+            err = "invalid tile in tiled diagram";
+            return false;
+        }
+    }
+    return true;
+}
+
+int DiagramTileFile::tileCount() const
+{
+    return myTiles.size();
+}
+
+int DiagramTileFile::tileSize() const
+{
+    return myTileSize;
+}
+
+int DiagramTileFile::linkCount() const
+{
+    return myLinkCount;
+}
+
+int DiagramTileFile::maxIndex() const
+{
+    return myMaxIndex;
+}
+
+// Zero for files written without one.
+quint64 DiagramTileFile::snapshotId() const
+{
+    return mySnapshotId;
+}
+
+QRect DiagramTileFile::tileRect(int tile) const
+{
+    const Tile &entry = myTiles[tile];
+    return QRect(entry.column * myTileSize, entry.row * myTileSize,
+                 myTileSize, myTileSize);
+}
+
+QRect DiagramTileFile::bounds() const
+{
+    QRect rect;
+    for (size_t i = 0; i < myTiles.size(); ++i)
+        rect |= tileRect(i);
+    return rect;
+}
+
+bool DiagramTileFile::readTile(int tile, std::vector<NodeRecord> &nodes,
+                               std::vector<TileLink> &links) const
+{
+    const Tile &entry = myTiles[tile];
+    const char *data = myData + entry.offset;
+    const char *end = data + entry.size;
+
+    NodeRecord node;
+    node.hasColors = true;
+    for (quint32 i = 0; i < entry.nodeCount; ++i) {
+        if (size_t(end - data) < NODE_SIZE)
+            return false;
+        node.index = readI32(data, 0);
+        node.x = readI32(data, 1);
+        node.y = readI32(data, 2);
+        node.textColor = readU32(data, 3);
+        node.outlineColor = readU32(data, 4);
+        node.backgroundColor = readU32(data, 5);
+        quint32 textSize = readU32(data, 6);
+        data += NODE_SIZE;
+        if (size_t(end - data) < textSize)
+            return false;
+        node.text.assign(data, textSize);
+        data += textSize;
+        nodes.push_back(node);
+    }
+
+    size_t words = myVersion == 1 ? 3 : 4;
+    if (size_t(end - data) < 4 * words * entry.linkCount)
+        return false;
+    TileLink link;
+    link.record.color = 0;
+    for (quint32 i = 0; i < entry.linkCount; ++i) {
+        link.id = readI32(data, words * i);
+        link.record.from = readI32(data, words * i + 1);
+        link.record.to = readI32(data, words * i + 2);
+        if (words == 4)
+            link.record.color = readU32(data, words * i + 3);
+        links.push_back(link);
+    }
+    return true;
+}
+
+// Links whose endpoints are not among nodes are dropped; link ids are
+// positions in links.
+bool DiagramTileWriter::write(QIODevice *device,
+                              const std::vector<NodeRecord> &nodes,
+                              const std::vector<LinkRecord> &links,
+                              quint64 snapshotId)
+{
+    struct Tile
+    {
+        std::vector<size_t> nodes;
+        std::vector<size_t> links;
+        quint64 size = 0;
+    };
+
+    if (links.size() > 0x7fffffffu)
+        return false;
+
+    std::map<TileKey, Tile> tiles;
+    std::unordered_map<int, TileKey> tileOfNode;
+    int maxIndex = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const NodeRecord &node = nodes[i];
+        TileKey key(DiagramTiles::tileCoordinate(node.x, TILE_SIZE),
+                    DiagramTiles::tileCoordinate(node.y, TILE_SIZE));
+        Tile &tile = tiles[key];
+        tile.nodes.push_back(i);
+        tile.size += NODE_SIZE + node.text.size();
+        tileOfNode[node.index] = key;
+        if (maxIndex < node.index)
+            maxIndex = node.index;
+    }
+
+    for (size_t i = 0; i < links.size(); ++i) {
+        auto from = tileOfNode.find(links[i].from);
+        auto to = tileOfNode.find(links[i].to);
+        if (from == tileOfNode.end() || to == tileOfNode.end())
+            continue;
+
+        Tile &tile = tiles[from->second];
+        tile.links.push_back(i);
+        tile.size += LINK_SIZE;
+        if (to->second != from->second) {
+            Tile &other = tiles[to->second];
+            other.links.push_back(i);
+            other.size += LINK_SIZE;
+        }
+    }
+
+    QByteArray head;
+    head.append(MAGIC, sizeof(MAGIC));
+    putU32(head, VERSION);
+    putU32(head, TILE_SIZE);
+    putU32(head, tiles.size());
+    putU32(head, links.size());
+    putU32(head, maxIndex);
+    putU64(head, snapshotId);
+
+    quint64 offset = HEADER_SIZE + ENTRY_SIZE * tiles.size();
+    for (const auto &entry: tiles) {
+        const Tile &tile = entry.second;
+        putU32(head, entry.first.first);
+        putU32(head, entry.first.second);
+        putU32(head, tile.nodes.size());
+        putU32(head, tile.links.size());
+        putU64(head, offset);
+        putU64(head, tile.size);
+        offset += tile.size;
+    }
+    if (device->write(head) != head.size())
+        return false;
+
+    QByteArray body;
+    for (const auto &entry: tiles) {
+        const Tile &tile = entry.second;
+        body.clear();
+        body.reserve(tile.size);
+        for (size_t i: tile.nodes) {
+            const NodeRecord &node = nodes[i];
+            putU32(body, node.index);
+            putU32(body, node.x);
+            putU32(body, node.y);
+            putU32(body, node.textColor);
+            putU32(body, node.outlineColor);
+            putU32(body, node.backgroundColor);
+            putU32(body, node.text.size());
+            body.append(node.text.data(), node.text.size());
+        }
+        for (size_t i: tile.links) {
+            putU32(body, i);
+            putU32(body, links[i].from);
+            putU32(body, links[i].to);
+            putU32(body, links[i].color);
+        }
+        if (device->write(body) != body.size())
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef DIAGRAMTILES_H
+#define DIAGRAMTILES_H
+
+#include <QFile>
+#include <QRect>
+#include <string>
+#include <vector>
+#include "diagramrecord.h"
+
+class QIODevice;
+
+// The .diagt format: nodes bucketed by the square scene tile that contains
+// their position, with a directory at the head of the file so that a
+// memory-mapped file can be read one tile at a time. A link is stored in
+// the tiles of both of its endpoints, under an id that is unique within the
+// file. All values are little-endian 32-bit words.
+//
+//   header     "DIAT", version, tile size, tile count t, link count,
+//              highest node index, 64-bit snapshot id
+//   directory  t entries of column, row, node count, link count,
+//              64-bit body offset, 64-bit body size
+//   bodies     per node: index, x, y, textColor, outlineColor,
+//              backgroundColor, text size, then the UTF-8 text;
+//              per link: id, from, to, color
+//
+// Version 1 files have no link colors.
+namespace DiagramTiles {
+bool isTiled(const char *data, size_t size);
+bool isTiledFile(const QString &fileName);
+int tileCoordinate(int value, int tileSize);
+}
+
+class DiagramTileFile
+{
+public:
+    struct TileLink
+    {
+        int id;
+        LinkRecord record;
+    };
+
+    DiagramTileFile();
+
+    bool open(const QString &fileName, std::string &err);
+
+    int tileCount() const;
+    int tileSize() const;
+    int linkCount() const;
+    int maxIndex() const;
+    quint64 snapshotId() const;
+    QRect tileRect(int tile) const;
+    QRect bounds() const;
+    bool readTile(int tile, std::vector<NodeRecord> &nodes,
+                  std::vector<TileLink> &links) const;
+
+private:
+    struct Tile
+    {
+        int column;
+        int row;
+        quint32 nodeCount;
+        quint32 linkCount;
+        quint64 offset;
+        quint64 size;
+    };
+
+    QFile myFile;
+    const char *myData;
+    quint64 mySize;
+    quint32 myVersion;
+    int myTileSize;
+    int myLinkCount;
+    int myMaxIndex;
+    quint64 mySnapshotId;
+    std::vector<Tile> myTiles;
+};
+
+class DiagramTileWriter
+{
+public:
+    static const int TILE_SIZE = 1024;
+
+    static bool write(QIODevice *device,
+                      const std::vector<NodeRecord> &nodes,
+                      const std::vector<LinkRecord> &links,
+                      quint64 snapshotId);
+};
+
+#endif
@@ -1,22 +1,87 @@
 #include <QtWidgets>
-#include <fstream>
-#include <string>
-#include <iterator>
 #include <iostream>
+#include <string>
 
+#include "diagramjournal.h"
+#include "diagramgridindex.h"
+#include "diagramloader.h"
+#include "diagramsaver.h"
+#include "diagramtiles.h"
 #include "diagramwindow.h"
+#include "edgelayer.h"
 #include "link.h"
+#include "linkitem.h"
 #include "node.h"
 #include "propertiesdialog.h"
 
 namespace {
 const bool AUTO_POS = true;
-const bool NON_AUTO_POS = false;
+
+// A journal is folded into a full save once it outgrows this size, or half
+// the size of the file it applies to, whichever is larger.
+const qint64 JOURNAL_COMPACT_SIZE = 1024 * 1024;
+
+// Tiles are updated at most this often while the view scrolls.
+const int TILE_UPDATE_INTERVAL = 50;
+// Live tiles are evicted once they are this many tiles out of view.
+const int TILE_KEEP_DISTANCE = 3;
 }
 
+// Applies journal records to the store loaded from the journal's file,
+// before any of its tiles are live.
+class DiagramWindow::JournalReplay : public DiagramJournal::Handler
+{
+public:
+    explicit JournalReplay(DiagramWindow *window) : window(window) {}
+
+    void addNode(const NodeRecord &record)
+    {
+        window->addNodeRecord(record);
+    }
+
+    void moveNode(int index, int x, int y)
+    {
+        window->store.moveNode(index, x, y);
+    }
+
+    void renameNode(int index, const std::string &text)
+    {
+        window->store.renameNode(index, text);
+    }
+
+    void recolorNode(const NodeRecord &record)
+    {
+        window->store.recolorNode(record);
+    }
+
+    void removeNode(int index)
+    {
+        window->store.removeNode(index);
+    }
+
+    void addLink(const LinkRecord &record)
+    {
+        window->addLinkRecord(record);
+    }
+
+    void removeLink(const LinkRecord &record)
+    {
+        window->store.removeLink(record);
+    }
+
+    void recolorLink(const LinkRecord &record)
+    {
+        window->store.recolorLink(record);
+    }
+
+private:
+    DiagramWindow *window;
+};
+
 DiagramWindow::DiagramWindow()
 {
     scene = new QGraphicsScene(0, 0, 600, 500);
+    DiagramGridIndex::install(scene);
 
     view = new QGraphicsView;
     view->setScene(scene);
@@ -26,24 +91,76 @@ DiagramWindow::DiagramWindow()
     view->setContextMenuPolicy(Qt::ActionsContextMenu);
     setCentralWidget(view);
 
+    edgeLayer = new EdgeLayer;
+    edgeLayer->hide();
+    scene->addItem(edgeLayer);
+    connect(edgeLayer, SIGNAL(selectionChanged()),
+            this, SLOT(updateActions()));
+
     minZ = 0;
     maxZ = 0;
     seqNumber = 0;
+    bulkInsertDepth = 0;
+    hasSavedState = false;
+    snapshotId = 0;
+    editSerial = 0;
+    savedEditSerial = 0;
+
+    tileTimer = new QTimer(this);
+    tileTimer->setSingleShot(true);
+    tileTimer->setInterval(TILE_UPDATE_INTERVAL);
+    connect(tileTimer, SIGNAL(timeout()), this, SLOT(updateTiles()));
+    foreach (QScrollBar *bar, QList<QScrollBar *>()
+                              << view->horizontalScrollBar()
+                              << view->verticalScrollBar()) {
+        connect(bar, SIGNAL(valueChanged(int)),
+                this, SLOT(scheduleTileUpdate()));
+        connect(bar, SIGNAL(rangeChanged(int,int)),
+                this, SLOT(scheduleTileUpdate()));
+    }
+
+    saver = new DiagramSaver(this);
+    connect(saver, SIGNAL(finished(QString,bool)),
+            this, SLOT(saveFinished(QString,bool)));
+
+    loader = new DiagramLoader(this);
+    loadProgress = 0;
+    loadedNodes = 0;
+    connect(loader, SIGNAL(batchReady()), this, SLOT(applyLoadedBatch()));
+    connect(loader, SIGNAL(finished(QString,int)),
+            this, SLOT(loadFinished(QString,int)));
 
     createActions();
     createMenus();
     createToolBars();
+    createStatusBar();
 
     connect(scene, SIGNAL(selectionChanged()),
-            this, SLOT(updateActions()));
+            this, SLOT(sceneSelectionChanged()));
+    connect(view, SIGNAL(rubberBandChanged(QRect,QPointF,QPointF)),
+            this, SLOT(rubberBandChanged(QRect,QPointF,QPointF)));
 
     setWindowTitle(tr("Diagram"));
     updateActions();
     setCurrentFile("");
 }
 
+// The window has no font of its own, so it sees application font changes;
+// nodes measure their text with that font.
+void DiagramWindow::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange) {
+        for (auto node: model.nodes())
+            node->fontChanged();
+    }
+    QMainWindow::changeEvent(event);
+}
+
+// A save still being written is finished first, so that the question is
+// only asked if the document is modified after all.
 void DiagramWindow::closeEvent(QCloseEvent *event)
 {
+    saver->waitForFinished();
     if (okToContinue()) {
         event->accept();
     } else {
@@ -53,13 +170,21 @@ void DiagramWindow::closeEvent(QCloseEvent *event)
 
 void DiagramWindow::clear()
 {
-    for (auto link: linkList)
+    for (auto link: model.links())
         delete link;
-    linkList.clear();
-
-    for (auto node: nodeList)
-        delete node.second;
-    nodeList.clear();
+    for (auto node: model.nodes())
+        delete node;
+    model.clear();
+    bulkNodes.clear();
+    store.clear();
+    liveLinks.clear();
+    linkIds.clear();
+    scene->setSceneRect(0, 0, 600, 500);
+
+    hasSavedState = false;
+    snapshotId = 0;
+    nodeChanges.clear();
+    linkChanges.clear();
 
     minZ = 0;
     maxZ = 0;
@@ -83,7 +208,8 @@ void DiagramWindow::open()
         clear();
         QString fileName = QFileDialog::getOpenFileName(this,
                                    tr("Open Diagram"), ".",
-                                   tr("Diagram files (*.diag)"));
+                                   tr("Diagram files "
+                                      "(*.diag *.diagb *.diagt)"));
         if (!fileName.isEmpty())
             loadFile(fileName);
     }
@@ -93,19 +219,41 @@ bool DiagramWindow::save()
 {
     if (curFile.isEmpty()) {
         return saveAs();
+    } else if (journalAction->isChecked() && hasSavedState) {
+        return saveJournal();
     } else {
         return saveFile(curFile);
     }
 }
 
+bool DiagramWindow::compact()
+{
+    if (curFile.isEmpty())
+        return saveAs();
+
+    return saveFile(curFile);
+}
+
 bool DiagramWindow::saveAs()
 {
+    QString binaryFilter = tr("Binary diagram files (*.diagb)");
+    QString tiledFilter = tr("Tiled diagram files (*.diagt)");
+    QString selectedFilter;
     QString fileName = QFileDialog::getSaveFileName(this,
                                     tr("Save diagram"), ".",
-                                    tr("Diagram files (*.diag)"));
+                                    tr("Diagram files (*.diag)") + ";;"
+                                    + binaryFilter + ";;" + tiledFilter,
+                                    &selectedFilter);
     if (fileName.isEmpty())
         return false;
 
+    if (selectedFilter == binaryFilter
+            && !fileName.endsWith(".diagb", Qt::CaseInsensitive))
+        fileName += ".diagb";
+    if (selectedFilter == tiledFilter
+            && !fileName.endsWith(".diagt", Qt::CaseInsensitive))
+        fileName += ".diagt";
+
     return saveFile(fileName);
 }
 
@@ -115,7 +263,7 @@ void DiagramWindow::addNode()
     Node *node = new Node(index);
     node->setText(tr("Node %1").arg(index));
     setupNode(node, AUTO_POS);
-    setWindowModified(true);
+    markModified();
 }
 
 void DiagramWindow::addLink()
@@ -126,28 +274,27 @@ void DiagramWindow::addLink()
 
     Link *link = new Link(nodes.first, nodes.second);
     setupLink(link);
-    setWindowModified(true);
+    markModified();
 }
 
 void DiagramWindow::del()
 {
     QList<QGraphicsItem *> items = scene->selectedItems();
-    QMutableListIterator<QGraphicsItem *> i(items);
-    while (i.hasNext()) {
-        QGraphicsItem *item = i.next();
-        Link *link = dynamic_cast<Link *>(item);
-        if (link) {
-            delete link;
-            i.remove();
-        }
+    QList<Node *> nodes;
+    foreach (QGraphicsItem *item, items) {
+        LinkItem *linkItem = dynamic_cast<LinkItem *>(item);
+        if (linkItem)
+            deleteLink(linkItem->link());
         Node *node = dynamic_cast<Node *>(item);
-        if (node) {
-            nodeList.erase(node->index());
-        }
+        if (node)
+            nodes.append(node);
     }
+    foreach (Link *link, edgeLayer->selectedLinks())
+        deleteLink(link);
 
-    qDeleteAll(items);
-    setWindowModified(true);
+    foreach (Node *node, nodes)
+        deleteNode(node);
+    markModified();
 }
 
 void DiagramWindow::cut()
@@ -157,7 +304,8 @@ void DiagramWindow::cut()
         return;
 
     copy();
-    delete node;
+    deleteNode(node);
+    markModified();
 }
 
 void DiagramWindow::copy()
@@ -188,7 +336,7 @@ void DiagramWindow::paste()
         node->setBackgroundColor(QColor(parts[3]));
         setupNode(node, AUTO_POS);
     }
-    setWindowModified(true);
+    markModified();
 }
 
 void DiagramWindow::bringToFront()
@@ -213,14 +361,21 @@ void DiagramWindow::properties()
         dialog.exec();
     } else if (link) {
         QColor color = QColorDialog::getColor(link->color(), this);
-        if (color.isValid())
+        if (color.isValid() && color != link->color()) {
             link->setColor(color);
+            recolorLink(link);
+            markModified();
+        }
     }
 }
 
 void DiagramWindow::updateActions()
 {
-    bool hasSelection = !scene->selectedItems().isEmpty();
+    if (bulkInsertDepth > 0)
+        return;
+
+    bool hasSelection = !scene->selectedItems().isEmpty()
+                        || !edgeLayer->selectedLinks().isEmpty();
     bool isNode = (selectedNode() != 0);
     bool isNodePair = (selectedNodePair() != NodePair());
 
@@ -241,6 +396,51 @@ void DiagramWindow::updateActions()
     }
 }
 
+// Selecting scene items replaces a selection of links in the edge layer,
+// as it would for links that are scene items. A rubber band selects both.
+void DiagramWindow::sceneSelectionChanged()
+{
+    if (!scene->selectedItems().isEmpty()
+            && !edgeLayer->isRubberBandActive())
+        edgeLayer->clearSelection();
+    updateActions();
+}
+
+// The view selects the scene items in a rubber band, and the edge layer
+// the links in it. A null rect marks the end of the band.
+void DiagramWindow::rubberBandChanged(const QRect &viewportRect,
+                                      const QPointF &fromScenePoint,
+                                      const QPointF &toScenePoint)
+{
+    if (!edgeLayer->isVisible())
+        return;
+
+    if (viewportRect.isNull()) {
+        edgeLayer->endRubberBand();
+        return;
+    }
+    bool extend = QApplication::keyboardModifiers() & Qt::ControlModifier;
+    edgeLayer->setRubberBand(QRectF(fromScenePoint, toScenePoint)
+                             .normalized(), extend);
+}
+
+// Moves every link between the edge layer and items of its own in the
+// scene. Links created later follow the current setting.
+void DiagramWindow::setEdgeLayerEnabled(bool enabled)
+{
+    edgeLayer->clearSelection();
+    for (auto link: model.links()) {
+        if (enabled) {
+            delete link->item();
+            edgeLayer->addLink(link);
+        } else {
+            edgeLayer->removeLink(link);
+            scene->addItem(new LinkItem(link));
+        }
+    }
+    edgeLayer->setVisible(enabled);
+}
+
 void DiagramWindow::createActions()
 {
     newAction = new QAction(tr("&New"), this);
@@ -266,6 +466,17 @@ void DiagramWindow::createActions()
                                   "name"));
     connect(saveAsAction, SIGNAL(triggered()), this, SLOT(saveAs()));
 
+    compactAction = new QAction(tr("Co&mpact"), this);
+    compactAction->setStatusTip(tr("Rewrite the diagram file in full and "
+                                   "discard its journal"));
+    connect(compactAction, SIGNAL(triggered()), this, SLOT(compact()));
+
+    journalAction = new QAction(tr("&Journal Saves"), this);
+    journalAction->setCheckable(true);
+    journalAction->setChecked(true);
+    journalAction->setStatusTip(tr("Save only the changes since the last "
+                                   "save, to a journal next to the file"));
+
     exitAction = new QAction(tr("E&xit"), this);
     exitAction->setShortcut(tr("Ctrl+Q"));
     connect(exitAction, SIGNAL(triggered()), this, SLOT(close()));
@@ -313,6 +524,13 @@ void DiagramWindow::createActions()
     propertiesAction = new QAction(tr("P&roperties..."), this);
     connect(propertiesAction, SIGNAL(triggered()),
             this, SLOT(properties()));
+
+    edgeLayerAction = new QAction(tr("&Batch Link Drawing"), this);
+    edgeLayerAction->setCheckable(true);
+    edgeLayerAction->setStatusTip(tr("Draw all links as one layer instead "
+                                     "of one scene item per link"));
+    connect(edgeLayerAction, SIGNAL(toggled(bool)),
+            this, SLOT(setEdgeLayerEnabled(bool)));
 }
 
 void DiagramWindow::createMenus()
@@ -322,6 +540,9 @@ void DiagramWindow::createMenus()
     fileMenu->addAction(openAction);
     fileMenu->addAction(saveAction);
     fileMenu->addAction(saveAsAction);
+    fileMenu->addAction(compactAction);
+    fileMenu->addAction(journalAction);
+    fileMenu->addSeparator();
     fileMenu->addAction(exitAction);
 
     editMenu = menuBar()->addMenu(tr("&Edit"));
@@ -337,6 +558,9 @@ void DiagramWindow::createMenus()
     editMenu->addAction(sendToBackAction);
     editMenu->addSeparator();
     editMenu->addAction(propertiesAction);
+
+    viewMenu = menuBar()->addMenu(tr("&View"));
+    viewMenu->addAction(edgeLayerAction);
 }
 
 void DiagramWindow::createToolBars()
@@ -359,6 +583,22 @@ void DiagramWindow::createToolBars()
     editToolBar->addAction(sendToBackAction);
 }
 
+void DiagramWindow::createStatusBar()
+{
+    saveProgress = new QProgressBar;
+    saveProgress->setRange(0, 100);
+    saveProgress->setMaximumWidth(150);
+    saveProgress->hide();
+    statusBar()->addPermanentWidget(saveProgress);
+    connect(saver, SIGNAL(progress(int)), saveProgress, SLOT(setValue(int)));
+}
+
+void DiagramWindow::markModified()
+{
+    ++editSerial;
+    setWindowModified(true);
+}
+
 void DiagramWindow::setZValue(int z)
 {
     Node *node = selectedNode();
@@ -366,26 +606,158 @@ void DiagramWindow::setZValue(int z)
         node->setZValue(z);
 }
 
+Node *DiagramWindow::findNode(int index) const
+{
+    return model.findNode(index);
+}
+
+// Removing the node from the store also removes its links there, those
+// without items included, and so does replaying its removal from the
+// journal. A node inserted during a bulk insertion leaves the list that
+// endBulkInsert() works through.
+void DiagramWindow::deleteNode(Node *node)
+{
+    for (Link *link: node->links()) {
+        forgetLink(link);
+        model.removeLink(link);
+    }
+    bulkNodes.removeOne(node);
+    store.removeNode(node->index());
+
+    auto iter = nodeChanges.find(node->index());
+    if (iter != nodeChanges.end() && (iter->second & NodeAdded))
+        nodeChanges.erase(iter);
+    else
+        nodeChanges[node->index()] = NodeRemoved;
+
+    model.removeNode(node);
+    delete node;
+}
+
+void DiagramWindow::deleteLink(Link *link)
+{
+    int id = forgetLink(link);
+    store.removeLink(id);
+    if (id >= 0) {
+        auto iter = linkChanges.find(id);
+        if (iter != linkChanges.end() && iter->second == LinkAdded)
+            linkChanges.erase(iter);
+        else
+            linkChanges[id] = LinkRemoved;
+    }
+    model.removeLink(link);
+    delete link;
+}
+
+// Adds a link created by the user to the store, and shows it.
 void DiagramWindow::setupLink(Link *link)
 {
-    scene->addItem(link);
-    linkList.insert(link);
+    int id = store.addLink(link->toRecord());
+    if (id >= 0)
+        linkChanges[id] = LinkAdded;
+    showLink(link, id);
+}
+
+// Shows the link of the store's link id in the edge layer when that is in
+// use, or else as an item in the scene.
+void DiagramWindow::showLink(Link *link, int id)
+{
+    if (edgeLayer->isVisible())
+        edgeLayer->addLink(link);
+    else
+        scene->addItem(new LinkItem(link));
+    model.addLink(link);
+    if (id >= 0) {
+        liveLinks[id] = link;
+        linkIds[link] = id;
+    }
 }
 
+// Copies the color of a link's item to the store. A link added since the
+// last save is journaled with its color; any other is journaled as
+// recolored.
+void DiagramWindow::recolorLink(Link *link)
+{
+    auto iter = linkIds.find(link);
+    if (iter == linkIds.end())
+        return;
+
+    int id = iter->second;
+    store.setLinkColor(id, link->color().rgba());
+    if (!linkChanges.count(id))
+        linkChanges[id] = LinkRecolored;
+}
+
+// Drops the item of a link from the id maps, and returns the link's id.
+int DiagramWindow::forgetLink(Link *link)
+{
+    auto iter = linkIds.find(link);
+    if (iter == linkIds.end())
+        return -1;
+
+    int id = iter->second;
+    liveLinks.erase(id);
+    linkIds.erase(iter);
+    return id;
+}
+
+// A new node becomes part of the live tile at its position; that tile is
+// made live first if it is not.
 void DiagramWindow::setupNode(Node *node, bool autoPos)
 {
     if (autoPos) {
         node->setPos(QPoint(80 + (100 * (seqNumber % 5)),
                     80 + (50 * ((seqNumber / 5) % 7))));
     }
-    scene->addItem(node);
-    if (seqNumber < node->index())
-        seqNumber = node->index();
+    DiagramStore::TileKey tile = store.tileAt(int(node->x()),
+                                              int(node->y()));
+    if (!store.isLive(tile))
+        loadTile(tile);
+    insertNode(node);
+    store.attachNode(node->index(), tile);
+    nodeChanges[node->index()] = NodeAdded;
+
+    if (bulkInsertDepth > 0) {
+        bulkNodes.append(node);
+        return;
+    }
 
     scene->clearSelection();
     node->setSelected(true);
     bringToFront();
-    nodeList[node->index()] = node;
+}
+
+void DiagramWindow::insertNode(Node *node)
+{
+    scene->addItem(node);
+    if (seqNumber < node->index())
+        seqNumber = node->index();
+    model.addNode(node);
+}
+
+// Between beginBulkInsert() and endBulkInsert(), setupNode() only adds
+// nodes to the scene. Stacking order, the selection of the last inserted
+// node and the action update are applied once, by the outermost
+// endBulkInsert(), instead of once per node.
+void DiagramWindow::beginBulkInsert()
+{
+    ++bulkInsertDepth;
+}
+
+void DiagramWindow::endBulkInsert()
+{
+    if (--bulkInsertDepth > 0)
+        return;
+
+    if (!bulkNodes.isEmpty()) {
+        foreach (Node *node, bulkNodes)
+            node->setZValue(++maxZ);
+
+        scene->clearSelection();
+        bulkNodes.last()->setSelected(true);
+        bulkNodes.clear();
+    }
+    updateActions();
 }
 
 Node *DiagramWindow::selectedNode() const
@@ -401,8 +773,12 @@ Node *DiagramWindow::selectedNode() const
 Link *DiagramWindow::selectedLink() const
 {
     QList<QGraphicsItem *> items = scene->selectedItems();
-    if (items.count() == 1) {
-        return dynamic_cast<Link *>(items.first());
+    QList<Link *> links = edgeLayer->selectedLinks();
+    if (items.count() == 1 && links.isEmpty()) {
+        LinkItem *item = dynamic_cast<LinkItem *>(items.first());
+        return item ? item->link() : 0;
+    } else if (items.isEmpty() && links.count() == 1) {
+        return links.first();
     } else {
         return 0;
     }
@@ -420,102 +796,417 @@ DiagramWindow::NodePair DiagramWindow::selectedNodePair() const
     return NodePair();
 }
 
-bool DiagramWindow::deserializeFromJson(const std::string &str)
+// Loaded records go to the store; updateTiles() creates the items of the
+// ones around the viewport. A record that lands in a tile that is already
+// live gets its item right away, and so does a link between two nodes that
+// have items.
+void DiagramWindow::addNodeRecord(const NodeRecord &record)
 {
-    using json11::Json;
-    std::string err;
-    auto json = Json::parse(str, err);
-    
-    if (!err.empty()) {
-        std::cerr << "parse json error: " << err << '\n';
+    if (!record.hasColors) {
+        NodeRecord colored = record;
+        Node::setDefaultColors(colored);
+        addNodeRecord(colored);
+        return;
+    }
+
+    DiagramStore::TileKey tile = store.tileAt(record.x, record.y);
+    if (store.isLive(tile)) {
+        insertNode(Node::newFromRecord(record));
+        store.attachNode(record.index, tile);
+    } else {
+        store.addNode(record);
+    }
+    if (seqNumber < record.index)
+        seqNumber = record.index;
+}
+
+void DiagramWindow::addLinkRecord(const LinkRecord &record)
+{
+    int id = store.addLink(record);
+    if (id < 0)
+        std::cerr << "invalid link index\n";
+    else
+        showStoredLink(id);
+}
+
+// Parsing runs on the loader's worker thread; records are added to the
+// store as their batches arrive, and the tiles around the viewport are
+// shown as they fill. The whole load is one bulk insertion, and the
+// progress dialog's Cancel discards what was loaded so far.
+void DiagramWindow::loadFile(const QString &fileName)
+{
+    if (DiagramTiles::isTiledFile(fileName)) {
+        openTiled(fileName);
+        return;
+    }
+
+    beginBulkInsert();
+    loadedNodes = 0;
+
+    loadProgress = new QProgressDialog(
+            tr("Opening %1...").arg(strippedName(fileName)),
+            tr("Cancel"), 0, 0, this);
+    loadProgress->setWindowModality(Qt::WindowModal);
+    loadProgress->setMinimumDuration(500);
+    connect(loadProgress, SIGNAL(canceled()), loader, SLOT(cancel()));
+
+    loader->start(fileName);
+}
+
+void DiagramWindow::applyLoadedBatch()
+{
+    applyBatch();
+}
+
+bool DiagramWindow::applyBatch()
+{
+    std::vector<NodeRecord> nodes;
+    std::vector<LinkRecord> links;
+    if (!loader->takeBatch(nodes, links))
         return false;
+
+    for (const auto &record: nodes)
+        addNodeRecord(record);
+    for (const auto &record: links)
+        addLinkRecord(record);
+
+    loadedNodes += nodes.size();
+    if (loadProgress)
+        loadProgress->setLabelText(tr("Loaded %1 nodes").arg(loadedNodes));
+    scene->setSceneRect(scene->sceneRect() | QRectF(store.bounds()));
+    scheduleTileUpdate();
+    return true;
+}
+
+void DiagramWindow::loadFinished(const QString &fileName, int result)
+{
+    if (result == DiagramLoader::Loaded) {
+        while (applyBatch())
+            ;
+    } else {
+        std::vector<NodeRecord> nodes;
+        std::vector<LinkRecord> links;
+        while (loader->takeBatch(nodes, links))
+            ;
     }
 
-    auto nodes = json["nodes"];
-    if (nodes.is_array()) {
-        for (auto nodeJson: nodes.array_items()) {
-            auto node = Node::newFromJson(nodeJson);
-            if (!node)
-                continue;
-            setupNode(node, NON_AUTO_POS);
+    loadProgress->deleteLater();
+    loadProgress = 0;
+
+    // The journal applies to the store's records, so the tiles shown during
+    // the load are handed back to it before a replay.
+    bool ok = (result == DiagramLoader::Loaded);
+    if (ok) {
+        snapshotId = loader->snapshotId();
+        DiagramJournal journal(fileName, snapshotId);
+        if (journal.size() > 0) {
+            for (const auto &tile: store.tiles()) {
+                if (store.isLive(tile))
+                    evictTile(tile, QRectF());
+            }
+            JournalReplay replay(this);
+            ok = journal.replay(replay);
         }
-        setWindowModified(true);
     }
+    endBulkInsert();
 
-    auto links = json["links"];
-    if (links.is_array()) {
-        for (auto linkJson: links.array_items()) {
-            auto link = Link::newFromJson(linkJson, nodeList);
-            if (!link)
-                continue;
-            setupLink(link);
-        }
-        setWindowModified(true);
+    if (!ok) {
+        clear();
+        if (result == DiagramLoader::OpenFailed)
+            QMessageBox::information(this, "Error", "open file fail!");
+        else if (result != DiagramLoader::Cancelled)
+            QMessageBox::information(this, "Error", "parse file fail!");
+        return;
     }
 
-    return true;
+    resetChanges();
+    scene->setSceneRect(scene->sceneRect() | QRectF(store.bounds()));
+    setCurrentFile(fileName);
+    updateTiles();
 }
 
-bool DiagramWindow::loadFile(const QString &fileName)
+// Only the directory of a tiled file is read here, unless there is a
+// journal to replay; updateTiles() reads the tiles around the viewport as
+// it moves.
+void DiagramWindow::openTiled(const QString &fileName)
 {
-    std::ifstream ifile(fileName.toStdString());
-    if (!ifile) {
+    std::string err;
+    if (!store.open(fileName, err)) {
+        clear();
         QMessageBox::information(this, "Error", "open file fail!");
-        return false;
+        return;
     }
 
-    std::istreambuf_iterator<char>  beg(ifile),  end;
-    std::string str(beg,  end);
-
-    if (!deserializeFromJson(str)) {
-        QMessageBox::information(this, "Error", "parse file fail!");
-        return false;
+    snapshotId = store.snapshotId();
+    DiagramJournal journal(fileName, snapshotId);
+    if (journal.size() > 0) {
+        JournalReplay replay(this);
+        if (!store.readAll() || !journal.replay(replay)) {
+            clear();
+            QMessageBox::information(this, "Error", "parse file fail!");
+            return;
+        }
     }
 
+    seqNumber = store.maxIndex();
+    resetChanges();
+    scene->setSceneRect(scene->sceneRect() | QRectF(store.bounds()));
     setCurrentFile(fileName);
+    updateTiles();
+}
 
-    return true;
+void DiagramWindow::scheduleTileUpdate()
+{
+    if (!tileTimer->isActive())
+        tileTimer->start();
 }
 
-json11::Json DiagramWindow::serializeToJson()
+// Makes the tiles within one tile of the visible area live, then evicts
+// live tiles that are far out of view.
+void DiagramWindow::updateTiles()
 {
-    using json11::Json;
-    Json::array nodes;
-    for (auto node: nodeList) {
-        auto obj = node.second->toJson();
-        nodes.push_back(obj);
+    QRectF visible = view->mapToScene(view->viewport()->rect())
+                     .boundingRect();
+    qreal margin = store.tileSize();
+    QRectF wanted = visible.adjusted(-margin, -margin, margin, margin);
+    qreal distance = TILE_KEEP_DISTANCE * margin;
+    QRectF kept = visible.adjusted(-distance, -distance, distance, distance);
+
+    std::vector<DiagramStore::TileKey> tiles = store.tiles();
+    for (const auto &tile: tiles) {
+        if (!store.isLive(tile) && wanted.intersects(store.tileRect(tile)))
+            loadTile(tile);
     }
-
-    Json::array links;
-    for (auto link: linkList) {
-        auto obj = link->toJson();
-        links.push_back(obj);
+    for (const auto &tile: tiles) {
+        if (store.isLive(tile) && !kept.intersects(store.tileRect(tile)))
+            evictTile(tile, kept);
     }
+}
 
-    Json json = Json::object({
-            {"nodes", nodes},
-            {"links", links}
-            });
+// Creates items for the records of a tile. A link is created once both of
+// its endpoints have items, by whichever of their tiles comes second.
+void DiagramWindow::loadTile(const DiagramStore::TileKey &tile)
+{
+    std::vector<NodeRecord> nodes;
+    if (!store.makeLive(tile, nodes))
+        statusBar()->showMessage(tr("Cannot read part of %1")
+                                 .arg(strippedName(curFile)), 2000);
+
+    for (const auto &record: nodes)
+        insertNode(Node::newFromRecord(record));
+    for (const auto &record: nodes)
+        showStoredLinks(record.index);
+}
 
-    return json;
+void DiagramWindow::showStoredLinks(int index)
+{
+    for (int id: store.linksOf(index))
+        showStoredLink(id);
 }
 
+// Creates the item of a stored link if both of its endpoints have items
+// and it has none yet.
+void DiagramWindow::showStoredLink(int id)
+{
+    if (liveLinks.count(id))
+        return;
+
+    const LinkRecord &record = store.linkRecord(id);
+    Node *fromNode = findNode(record.from);
+    Node *toNode = findNode(record.to);
+    if (!fromNode || !toNode)
+        return;
+
+    Link *link = new Link(fromNode, toNode);
+    unsigned int color = store.linkColor(id);
+    if (color)
+        link->setColor(QColor::fromRgba(color));
+    showLink(link, id);
+}
+
+// Hands the nodes of a tile back to the store as they are now, and deletes
+// their items and those of their links. A node that has been moved to a
+// tile that is to be kept joins that tile instead.
+void DiagramWindow::evictTile(const DiagramStore::TileKey &tile,
+                              const QRectF &kept)
+{
+    for (int index: store.liveNodes(tile)) {
+        Node *node = findNode(index);
+        if (!node)
+            continue;
+
+        NodeRecord record = node->toRecord();
+        DiagramStore::TileKey target = store.tileAt(record.x, record.y);
+        if (target != tile && kept.intersects(store.tileRect(target))) {
+            if (!store.isLive(target))
+                loadTile(target);
+            store.attachNode(index, target);
+            continue;
+        }
+
+        for (Link *link: node->links()) {
+            forgetLink(link);
+            model.removeLink(link);
+        }
+        collectChanges(node);
+        store.storeNode(record);
+        model.removeNode(node);
+        delete node;
+    }
+    store.release(tile);
+}
+
+// Tiles still in a .diagt file are left in the snapshot for the saver's
+// worker thread to read.
+void DiagramWindow::takeSnapshot(DiagramStore::Snapshot &snapshot)
+{
+    store.snapshot(snapshot);
+    std::vector<NodeRecord> &nodes = snapshot.nodes;
+    nodes.reserve(nodes.size() + model.nodes().size());
+    for (auto node: model.nodes())
+        nodes.push_back(node->toRecord());
+}
+
+// The snapshot is taken here; serializing and writing it happen on the
+// saver's worker thread. The modified flag is cleared by saveFinished(),
+// unless the diagram was edited in the meantime.
 bool DiagramWindow::saveFile(const QString &fileName)
 {
-    std::ofstream ofile(fileName.toStdString());
-    if (!ofile) {
+    DiagramStore::Snapshot snapshot;
+    takeSnapshot(snapshot);
+    resetChanges();
+    quint64 id;
+    do {
+        id = QRandomGenerator::global()->generate64();
+    } while (id == 0 || id == snapshotId);
+    saver->start(fileName, snapshot, id);
+
+    bool modified = isWindowModified();
+    setCurrentFile(fileName);
+    setWindowModified(modified);
+    savedEditSerial = editSerial;
+
+    saveProgress->setValue(0);
+    saveProgress->show();
+    statusBar()->showMessage(tr("Saving %1...").arg(strippedName(fileName)));
+
+    return true;
+}
+
+void DiagramWindow::saveFinished(const QString &fileName, bool ok)
+{
+    saveProgress->hide();
+    statusBar()->clearMessage();
+
+    if (!ok) {
+        hasSavedState = false;
+        QMessageBox::information(this, "Error", "save file fail!");
+        return;
+    }
+
+    // Journal records go on top of the new file from now on.
+    if (fileName == curFile)
+        snapshotId = saver->snapshotId();
+    if (fileName == curFile && editSerial == savedEditSerial)
+        setWindowModified(false);
+    statusBar()->showMessage(tr("Saved %1").arg(strippedName(fileName)),
+                             2000);
+}
+
+// Appends the edits recorded since curFile was last written. Records are
+// ordered so that replay never refers to a node that does not exist yet:
+// link removals, node changes, then link additions and recolorings. Links
+// added or recolored and later removed together with one of their
+// endpoints are left out.
+bool DiagramWindow::saveJournal()
+{
+    saver->waitForFinished();
+    DiagramJournal journal(curFile, snapshotId);
+
+    for (auto node: model.nodes())
+        collectChanges(node);
+
+    for (const auto &entry: linkChanges) {
+        if (entry.second == LinkRemoved)
+            journal.removeLink(store.linkRecord(entry.first));
+    }
+
+    for (const auto &entry: nodeChanges) {
+        int changes = entry.second;
+        NodeRecord node;
+        if (changes & NodeRemoved) {
+            journal.removeNode(entry.first);
+        } else if (!currentRecord(entry.first, node)) {
+            continue;
+        } else if (changes & NodeAdded) {
+            journal.addNode(node);
+        } else {
+            if (changes & Node::Moved)
+                journal.moveNode(node.index, node.x, node.y);
+            if (changes & Node::Renamed)
+                journal.renameNode(node.index, node.text);
+            if (changes & Node::Recolored)
+                journal.recolorNode(node);
+        }
+    }
+
+    for (const auto &entry: linkChanges) {
+        if (!store.isLinkPresent(entry.first))
+            continue;
+        if (entry.second == LinkAdded)
+            journal.addLink(store.linkRecord(entry.first));
+        else if (entry.second == LinkRecolored)
+            journal.recolorLink(store.linkRecord(entry.first));
+    }
+
+    if (!journal.commit()) {
         QMessageBox::information(this, "Error", "save file fail!");
         return false;
     }
 
-    auto json = serializeToJson();
-    ofile << json.dump() << std::endl;
+    nodeChanges.clear();
+    linkChanges.clear();
 
-    setCurrentFile(fileName);
+    qint64 limit = qMax(JOURNAL_COMPACT_SIZE, QFileInfo(curFile).size() / 2);
+    if (journal.size() > limit)
+        return saveFile(curFile);
 
+    setCurrentFile(curFile);
     return true;
 }
 
+// Moves the edits made to a node's item into nodeChanges, before the item
+// goes away or the journal is written.
+void DiagramWindow::collectChanges(Node *node)
+{
+    if (node->changes()) {
+        nodeChanges[node->index()] |= node->changes();
+        node->clearChanges();
+    }
+}
+
+// Makes the document as it is now the state that journal records apply
+// to.
+void DiagramWindow::resetChanges()
+{
+    nodeChanges.clear();
+    linkChanges.clear();
+    for (auto node: model.nodes())
+        node->clearChanges();
+    hasSavedState = true;
+}
+
+// The record of a node with an item, or of one in the store.
+bool DiagramWindow::currentRecord(int index, NodeRecord &record)
+{
+    Node *node = findNode(index);
+    if (node) {
+        record = node->toRecord();
+        return true;
+    }
+    return store.storedNode(index, record);
+}
+
 void DiagramWindow::setCurrentFile(const QString &fileName)
 {
     curFile = fileName;
@@ -535,6 +1226,8 @@ QString DiagramWindow::strippedName(const QString &fullFileName)
     return QFileInfo(fullFileName).fileName();
 }
 
+// Saving here waits for the file to be written, so that the document is
+// kept if writing it fails.
 bool DiagramWindow::okToContinue()
 {
     if (isWindowModified()) {
@@ -544,7 +1237,7 @@ bool DiagramWindow::okToContinue()
                 QMessageBox::Yes | QMessageBox::No
                 | QMessageBox::Cancel);
         if (r == QMessageBox::Yes) {
-            return save();
+            return save() && saver->waitForFinished();
         } else if (r == QMessageBox::Cancel) {
             return false;
         }
@@ -2,16 +2,26 @@
 #define DIAGRAMWINDOW_H
 
 #include <QMainWindow>
+#include <QList>
 #include <QPair>
-#include <set>
 #include <map>
 #include <string>
-#include "json11.hpp"
+#include <vector>
+#include "diagramrecord.h"
+#include "diagramstore.h"
+#include "graphmodel.h"
 
 class QAction;
 class QGraphicsItem;
 class QGraphicsScene;
 class QGraphicsView;
+class QProgressBar;
+class QProgressDialog;
+class QRectF;
+class QTimer;
+class DiagramLoader;
+class DiagramSaver;
+class EdgeLayer;
 class Link;
 class Node;
 
@@ -23,6 +33,7 @@ public:
     DiagramWindow();
 
 protected:
+    void changeEvent(QEvent *event);
     void closeEvent(QCloseEvent *event);
 
 private slots:
@@ -30,6 +41,7 @@ private slots:
     void open();
     bool save();
     bool saveAs();
+    bool compact();
     void addNode();
     void addLink();
     void del();
@@ -40,37 +52,78 @@ private slots:
     void sendToBack();
     void properties();
     void updateActions();
+    void sceneSelectionChanged();
+    void rubberBandChanged(const QRect &viewportRect,
+                           const QPointF &fromScenePoint,
+                           const QPointF &toScenePoint);
+    void setEdgeLayerEnabled(bool enabled);
+    void saveFinished(const QString &fileName, bool ok);
+    void applyLoadedBatch();
+    void loadFinished(const QString &fileName, int result);
+    void scheduleTileUpdate();
+    void updateTiles();
 
 private:
     typedef QPair<Node *, Node *> NodePair;
+    class JournalReplay;
+
+    // Edits since the file was last written, kept for the journal. Nodes
+    // carry Node::Change flags, or one of these.
+    enum { NodeAdded = 0x100, NodeRemoved = 0x200 };
+    enum LinkChange { LinkAdded, LinkRemoved, LinkRecolored };
 
     void createActions();
     void createMenus();
     void createToolBars();
+    void createStatusBar();
+    void markModified();
     void setZValue(int z);
     void setupNode(Node *node, bool autoPos);
+    void insertNode(Node *node);
+    void beginBulkInsert();
+    void endBulkInsert();
+    Node *findNode(int index) const;
+    void deleteNode(Node *node);
+    void deleteLink(Link *link);
     Node *selectedNode() const;
     Link *selectedLink() const;
     NodePair selectedNodePair() const;
 
-    bool loadFile(const QString &fileName);
+    void loadFile(const QString &fileName);
+    void openTiled(const QString &fileName);
+    void loadTile(const DiagramStore::TileKey &tile);
+    void evictTile(const DiagramStore::TileKey &tile, const QRectF &kept);
+    void showStoredLinks(int index);
+    void showStoredLink(int id);
+    bool applyBatch();
     bool saveFile(const QString &fileName);
+    bool saveJournal();
+    void collectChanges(Node *node);
+    void resetChanges();
+    bool currentRecord(int index, NodeRecord &record);
     void setCurrentFile(const QString &fileName);
     QString strippedName(const QString &fullFileName);
     bool okToContinue();
-    json11::Json serializeToJson();
+    void takeSnapshot(DiagramStore::Snapshot &snapshot);
     void clear();
-    bool deserializeFromJson(const std::string &str);
+    void addNodeRecord(const NodeRecord &record);
+    void addLinkRecord(const LinkRecord &record);
     void setupLink(Link *link);
+    void showLink(Link *link, int id);
+    void recolorLink(Link *link);
+    int forgetLink(Link *link);
 
     QMenu *fileMenu;
     QMenu *editMenu;
+    QMenu *viewMenu;
     QToolBar *editToolBar;
     QToolBar *fileToolBar;
     QAction *newAction;
     QAction *openAction;
     QAction *saveAction;
     QAction *saveAsAction;
+    QAction *compactAction;
+    QAction *journalAction;
     QAction *exitAction;
     QAction *addNodeAction;
     QAction *addLinkAction;
@@ -81,16 +134,38 @@ private:
     QAction *bringToFrontAction;
     QAction *sendToBackAction;
     QAction *propertiesAction;
+    QAction *edgeLayerAction;
 
     QGraphicsScene *scene;
     QGraphicsView *view;
+    EdgeLayer *edgeLayer;
+    QProgressBar *saveProgress;
+    DiagramSaver *saver;
+    DiagramLoader *loader;
+    QProgressDialog *loadProgress;
+    size_t loadedNodes;
 
     int minZ;
     int maxZ;
     int seqNumber;
+    int bulkInsertDepth;
+    QList<Node *> bulkNodes;
     QString curFile;
-    std::set<Link *> linkList;
-    std::map<int, Node *> nodeList;
+    GraphModel model;
+    unsigned int editSerial;
+    unsigned int savedEditSerial;
+    quint64 snapshotId;
+    bool hasSavedState;
+    std::map<int, int> nodeChanges;
+    std::map<int, LinkChange> linkChanges;
+
+    // The document itself. Only the nodes of the store's live tiles, those
+    // around the viewport, have items in the scene and in model; a link has
+    // an item while both of its endpoints do.
+    DiagramStore store;
+    QTimer *tileTimer;
+    std::map<int, Link *> liveLinks;
+    std::map<Link *, int> linkIds;
 };
 
 #endif
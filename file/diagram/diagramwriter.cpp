@@ -0,0 +1,104 @@
+#include <QIODevice>
+#include <cstdio>
+
+#include "diagramwriter.h"
+#include "json11.hpp"
+
+namespace {
+const size_t BUFFER_SIZE = 64 * 1024;
+}
+
+DiagramWriter::DiagramWriter(QIODevice *device)
+    : myDevice(device), myOk(true)
+{
+    myBuffer.reserve(BUFFER_SIZE + 256);
+}
+
+// Keys are written in json11's sorted order: "links" before "nodes" before
+// "snapshot", and the members of each element alphabetically. A zero
+// snapshot id is left out.
+bool DiagramWriter::write(const std::vector<NodeRecord> &nodes,
+                          const std::vector<LinkRecord> &links,
+                          unsigned long long snapshotId,
+                          const ProgressCallback &progress)
+{
+    size_t total = nodes.size() + links.size();
+    size_t done = 0;
+
+    put("{\"links\": [");
+    for (size_t i = 0; i < links.size(); ++i) {
+        if (i > 0)
+            put(", ");
+        writeLink(links[i]);
+        if (!flushIfFull())
+            return false;
+        if (progress)
+            progress(++done, total);
+    }
+
+    put("], \"nodes\": [");
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (i > 0)
+            put(", ");
+        writeNode(nodes[i]);
+        if (!flushIfFull())
+            return false;
+        if (progress)
+            progress(++done, total);
+    }
+    put("]");
+    if (snapshotId) {
+        char id[17];
+        snprintf(id, sizeof(id), "%016llx", snapshotId);
+        put(", \"snapshot\": \"");
+        put(id);
+        put("\"");
+    }
+    put("}\n");
+
+    return flush();
+}
+
+void DiagramWriter::put(const char *text)
+{
+    myBuffer += text;
+}
+
+void DiagramWriter::writeNode(const NodeRecord &node)
+{
+    put("{\"index\": ");
+    json11::dump_number(node.index, myBuffer);
+    put(", \"text\": ");
+    json11::dump_string(node.text, myBuffer);
+    put(", \"x\": ");
+    json11::dump_number(node.x, myBuffer);
+    put(", \"y\": ");
+    json11::dump_number(node.y, myBuffer);
+    put("}");
+}
+
+void DiagramWriter::writeLink(const LinkRecord &link)
+{
+    put("{\"from\": ");
+    json11::dump_number(link.from, myBuffer);
+    put(", \"to\": ");
+    json11::dump_number(link.to, myBuffer);
+    put("}");
+}
+
+bool DiagramWriter::flushIfFull()
+{
+    if (myBuffer.size() < BUFFER_SIZE)
+        return myOk;
+    return flush();
+}
+
+bool DiagramWriter::flush()
+{
+    if (!myBuffer.empty()) {
+        myOk = myOk && myDevice->write(myBuffer.data(), myBuffer.size())
+                       == qint64(myBuffer.size());
+        myBuffer.clear();
+    }
+    return myOk;
+}
@@ -0,0 +1,38 @@
+#ifndef DIAGRAMWRITER_H
+#define DIAGRAMWRITER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "diagramrecord.h"
+
+class QIODevice;
+
+// Writes records as .diag text in a single pass through a fixed-size
+// buffer, producing the same bytes as json11's dump() of the equivalent
+// document without building it.
+class DiagramWriter
+{
+public:
+    typedef std::function<void(size_t done, size_t total)> ProgressCallback;
+
+    explicit DiagramWriter(QIODevice *device);
+
+    bool write(const std::vector<NodeRecord> &nodes,
+               const std::vector<LinkRecord> &links,
+               unsigned long long snapshotId = 0,
+               const ProgressCallback &progress = ProgressCallback());
+
+private:
+    void put(const char *text);
+    void writeNode(const NodeRecord &node);
+    void writeLink(const LinkRecord &link);
+    bool flushIfFull();
+    bool flush();
+
+    QIODevice *myDevice;
+    std::string myBuffer;
+    bool myOk;
+};
+
+#endif
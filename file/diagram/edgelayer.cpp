@@ -0,0 +1,245 @@
+#include <QtWidgets>
+#include <cmath>
+
+#include "edgelayer.h"
+#include "link.h"
+#include "node.h"
+
+namespace {
+// Links can end anywhere nodes can be dragged to, so the layer claims a
+// fixed area far larger than any diagram instead of tracking their extent.
+const qreal LAYER_EXTENT = 1e7;
+// Distance in scene units within which a press selects a link.
+const qreal HIT_DISTANCE = 4;
+
+QRectF lineRect(const QLineF &line)
+{
+    return QRectF(line.p1(), line.p2()).normalized()
+           .adjusted(-HIT_DISTANCE, -HIT_DISTANCE, HIT_DISTANCE, HIT_DISTANCE);
+}
+
+qreal distanceToSegment(const QPointF &pos, const QLineF &line)
+{
+    QPointF d = line.p2() - line.p1();
+    qreal length2 = d.x() * d.x() + d.y() * d.y();
+    qreal t = 0;
+    if (length2 > 0) {
+        QPointF v = pos - line.p1();
+        t = qBound(qreal(0), (v.x() * d.x() + v.y() * d.y()) / length2,
+                   qreal(1));
+    }
+    QPointF nearest = line.p1() + t * d;
+    return std::hypot(pos.x() - nearest.x(), pos.y() - nearest.y());
+}
+
+// Clips line to rect, and tells whether anything is left of it.
+bool lineMeetsRect(const QLineF &line, const QRectF &rect)
+{
+    const qreal p[4] = { -line.dx(), line.dx(), -line.dy(), line.dy() };
+    const qreal q[4] = { line.x1() - rect.left(), rect.right() - line.x1(),
+                         line.y1() - rect.top(), rect.bottom() - line.y1() };
+    qreal t0 = 0;
+    qreal t1 = 1;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0) {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+        qreal t = q[i] / p[i];
+        if (p[i] < 0)
+            t0 = qMax(t0, t);
+        else
+            t1 = qMin(t1, t);
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+}
+
+EdgeLayer::EdgeLayer()
+    : myRubberBandActive(false)
+{
+    setFlag(ItemUsesExtendedStyleOption);
+    setZValue(-1);
+}
+
+void EdgeLayer::addLink(Link *link)
+{
+    link->setLayer(this);
+    myPlaces.insert(link, myGrid.insert(link, lineRect(link->line())));
+    update(lineRect(link->line()));
+}
+
+void EdgeLayer::removeLink(Link *link)
+{
+    link->setLayer(0);
+    auto iter = myPlaces.find(link);
+    if (iter != myPlaces.end()) {
+        myGrid.remove(link, iter.value());
+        myPlaces.erase(iter);
+    }
+    update(lineRect(link->line()));
+    myRubberBandBase.remove(link);
+    if (mySelection.remove(link))
+        emit selectionChanged();
+}
+
+// Called after the line or the color of a link has changed.
+void EdgeLayer::linkChanged(Link *link, const QLineF &oldLine)
+{
+    QLineF newLine = link->line();
+    auto iter = myPlaces.find(link);
+    if (newLine != oldLine && iter != myPlaces.end()) {
+        myGrid.remove(link, iter.value());
+        iter.value() = myGrid.insert(link, lineRect(newLine));
+    }
+    update(lineRect(oldLine) | lineRect(newLine));
+}
+
+QList<Link *> EdgeLayer::selectedLinks() const
+{
+    return mySelection.values();
+}
+
+void EdgeLayer::clearSelection()
+{
+    if (mySelection.isEmpty())
+        return;
+
+    foreach (Link *link, mySelection)
+        update(lineRect(link->line()));
+    mySelection.clear();
+    emit selectionChanged();
+}
+
+// Selects the links that cross rect, a rubber band being dragged out in
+// the view. Each call replaces the links selected by the previous one; the
+// selection from before the band stays if extend is set.
+void EdgeLayer::setRubberBand(const QRectF &rect, bool extend)
+{
+    if (!myRubberBandActive) {
+        myRubberBandActive = true;
+        if (extend)
+            myRubberBandBase = mySelection;
+    }
+
+    QSet<Link *> selection = myRubberBandBase;
+    myGrid.query(rect, [&](Link *link) {
+        if (lineMeetsRect(link->line(), rect))
+            selection.insert(link);
+    });
+    setSelection(selection);
+}
+
+void EdgeLayer::endRubberBand()
+{
+    myRubberBandActive = false;
+    myRubberBandBase.clear();
+}
+
+bool EdgeLayer::isRubberBandActive() const
+{
+    return myRubberBandActive;
+}
+
+QRectF EdgeLayer::boundingRect() const
+{
+    return QRectF(-LAYER_EXTENT, -LAYER_EXTENT,
+                  2 * LAYER_EXTENT, 2 * LAYER_EXTENT);
+}
+
+void EdgeLayer::paint(QPainter *painter,
+                      const QStyleOptionGraphicsItem *option,
+                      QWidget * /* widget */)
+{
+    if (Node::detailFor(option->levelOfDetailFromTransform(
+                            painter->worldTransform())) == Node::PointDetail)
+        painter->setRenderHint(QPainter::Antialiasing, false);
+
+    QHash<QRgb, QVector<QLineF> > batches;
+    QList<Link *> selected;
+    myGrid.query(option->exposedRect, [&](Link *link) {
+        QLineF line = link->line();
+        if (!lineRect(line).intersects(option->exposedRect))
+            return;
+        if (mySelection.contains(link))
+            selected.append(link);
+        else
+            batches[link->color().rgba()].append(line);
+    });
+
+    for (auto iter = batches.constBegin(); iter != batches.constEnd(); ++iter) {
+        painter->setPen(QPen(QColor::fromRgba(iter.key()), 1.0));
+        painter->drawLines(iter.value());
+    }
+
+    foreach (Link *link, selected) {
+        QPen pen(link->color(), 2, Qt::DotLine);
+        painter->setPen(pen);
+        painter->drawLine(link->line());
+    }
+}
+
+// Presses that miss every link are passed on, so that nodes below and
+// rubber-band selection on empty space keep working. Such a press keeps
+// the selection for a rubber band that extends it.
+void EdgeLayer::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    Link *link = linkAt(event->scenePos());
+    if (!link) {
+        if (!(event->modifiers() & Qt::ControlModifier))
+            clearSelection();
+        event->ignore();
+        return;
+    }
+
+    if (event->modifiers() & Qt::ControlModifier) {
+        if (!mySelection.remove(link))
+            mySelection.insert(link);
+    } else {
+        scene()->clearSelection();
+        foreach (Link *other, mySelection)
+            update(lineRect(other->line()));
+        mySelection.clear();
+        mySelection.insert(link);
+    }
+    update(lineRect(link->line()));
+    emit selectionChanged();
+}
+
+Link *EdgeLayer::linkAt(const QPointF &pos) const
+{
+    Link *nearest = 0;
+    qreal nearestDistance = HIT_DISTANCE;
+    myGrid.query(QRectF(pos, QSizeF(0, 0)), [&](Link *link) {
+        QLineF line = link->line();
+        if (!lineRect(line).contains(pos))
+            return;
+        qreal distance = distanceToSegment(pos, line);
+        if (distance <= nearestDistance) {
+            nearest = link;
+            nearestDistance = distance;
+        }
+    });
+    return nearest;
+}
+
+// Repaints the links that join or leave the selection.
+void EdgeLayer::setSelection(const QSet<Link *> &selection)
+{
+    if (selection == mySelection)
+        return;
+
+    foreach (Link *link, selection) {
+        if (!mySelection.contains(link))
+            update(lineRect(link->line()));
+    }
+    foreach (Link *link, mySelection) {
+        if (!selection.contains(link))
+            update(lineRect(link->line()));
+    }
+    mySelection = selection;
+    emit selectionChanged();
+}
@@ -0,0 +1,55 @@
+#ifndef EDGELAYER_H
+#define EDGELAYER_H
+
+#include <QGraphicsObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include "diagramgrid.h"
+
+class Link;
+
+// Draws links as a single scene item instead of one item per link. Links
+// attached to the layer have no items: the layer keeps their segments in a
+// DiagramGrid, each paint draws the links the grid finds in the exposed
+// area with one drawLines() call per color, and the layer hit-tests and
+// selects them itself, by presses and by the view's rubber band.
+class EdgeLayer : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    EdgeLayer();
+
+    void addLink(Link *link);
+    void removeLink(Link *link);
+    void linkChanged(Link *link, const QLineF &oldLine);
+
+    QList<Link *> selectedLinks() const;
+    void clearSelection();
+    void setRubberBand(const QRectF &rect, bool extend);
+    void endRubberBand();
+    bool isRubberBandActive() const;
+
+    QRectF boundingRect() const;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+signals:
+    void selectionChanged();
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event);
+
+private:
+    Link *linkAt(const QPointF &pos) const;
+    void setSelection(const QSet<Link *> &selection);
+
+    DiagramGrid<Link *> myGrid;
+    QHash<Link *, DiagramGrid<Link *>::Place> myPlaces;
+    QSet<Link *> mySelection;
+    bool myRubberBandActive;
+    QSet<Link *> myRubberBandBase;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "graphmodel.h"
+#include "link.h"
+#include "node.h"
+
+// A node whose index is already taken replaces the older node in index
+// lookups; both stay in the model.
+void GraphModel::addNode(Node *node)
+{
+    SlotHandle handle = myNodes.insert(node);
+    node->setHandle(handle);
+    myNodeHandles[node->index()] = handle;
+}
+
+void GraphModel::removeNode(Node *node)
+{
+    SlotHandle handle = node->handle();
+    if (!myNodes.erase(handle))
+        return;
+
+    auto iter = myNodeHandles.find(node->index());
+    if (iter != myNodeHandles.end()
+            && iter->second.slot == handle.slot
+            && iter->second.generation == handle.generation)
+        myNodeHandles.erase(iter);
+    node->setHandle(SlotHandle());
+}
+
+Node *GraphModel::findNode(int index) const
+{
+    auto iter = myNodeHandles.find(index);
+    if (iter == myNodeHandles.end())
+        return 0;
+    Node *const *node = myNodes.find(iter->second);
+    return node ? *node : 0;
+}
+
+const SlotMap<Node *> &GraphModel::nodes() const
+{
+    return myNodes;
+}
+
+void GraphModel::addLink(Link *link)
+{
+    link->setHandle(myLinks.insert(link));
+}
+
+void GraphModel::removeLink(Link *link)
+{
+    if (myLinks.erase(link->handle()))
+        link->setHandle(SlotHandle());
+}
+
+const SlotMap<Link *> &GraphModel::links() const
+{
+    return myLinks;
+}
+
+void GraphModel::clear()
+{
+    myNodes.clear();
+    myLinks.clear();
+    myNodeHandles.clear();
+}
@@ -0,0 +1,35 @@
+#ifndef GRAPHMODEL_H
+#define GRAPHMODEL_H
+
+#include <unordered_map>
+#include "slotmap.h"
+
+class Link;
+class Node;
+
+// The nodes and links of a diagram, held in slot maps: adding, removing and
+// finding an item take constant time, and iteration walks contiguous
+// arrays in an order that does not depend on item addresses. Each item
+// keeps its own handle; nodes can also be found by their index. The model
+// does not own the items.
+class GraphModel
+{
+public:
+    void addNode(Node *node);
+    void removeNode(Node *node);
+    Node *findNode(int index) const;
+    const SlotMap<Node *> &nodes() const;
+
+    void addLink(Link *link);
+    void removeLink(Link *link);
+    const SlotMap<Link *> &links() const;
+
+    void clear();
+
+private:
+    SlotMap<Node *> myNodes;
+    SlotMap<Link *> myLinks;
+    std::unordered_map<int, SlotHandle> myNodeHandles;
+};
+
+#endif
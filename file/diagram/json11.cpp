@@ -20,15 +20,42 @@
  */
 
 #include "json11.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstddef>
 #include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+// std::to_chars/std::from_chars for both integers and doubles: locale-independent,
+// shortest round-trip output, and parsing straight from the input without a copy.
+// Benchmarks define JSON11_NO_CHARCONV to compare with snprintf/strtod.
+#if defined(__cpp_lib_to_chars) && !defined(JSON11_NO_CHARCONV)
+#define JSON11_CHARCONV 1
+#endif
+
+// Parsed objects of at most this many members are stored as flat sorted vectors, larger ones
+// as std::map. Benchmarks build the parser with 0 to compare the two.
+#ifndef JSON11_SMALL_OBJECT_SIZE
+#define JSON11_SMALL_OBJECT_SIZE 8
+#endif
 
 namespace json11 {
 
 static const int max_depth = 200;
+static const size_t arena_first_block = 4 * 1024;
+static const size_t arena_max_block = 1024 * 1024;
+static const size_t small_object_size = JSON11_SMALL_OBJECT_SIZE;
 
 using std::string;
 using std::vector;
@@ -37,6 +64,10 @@ using std::make_shared;
 using std::initializer_list;
 using std::move;
 
+/* Storage for small parsed objects: members sorted by key, without duplicates.
+ */
+typedef vector<std::pair<string, Json>> flat_object;
+
 /* Helper for representing null - just a do-nothing struct, plus comparison
  * operators so the helpers in JsonValue work. We can't use nullptr_t because
  * it may not be orderable.
@@ -57,8 +88,12 @@ static void dump(NullStruct, string &out) {
 static void dump(double value, string &out) {
     if (std::isfinite(value)) {
         char buf[32];
+#ifdef JSON11_CHARCONV
+        out.append(buf, std::to_chars(buf, buf + sizeof buf, value).ptr);
+#else
         snprintf(buf, sizeof buf, "%.17g", value);
         out += buf;
+#endif
     } else {
         out += "null";
     }
@@ -66,8 +101,12 @@ static void dump(double value, string &out) {
 
 static void dump(int value, string &out) {
     char buf[32];
+#ifdef JSON11_CHARCONV
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, value).ptr);
+#else
     snprintf(buf, sizeof buf, "%d", value);
     out += buf;
+#endif
 }
 
 static void dump(bool value, string &out) {
@@ -123,7 +162,8 @@ static void dump(const Json::array &values, string &out) {
     out += "]";
 }
 
-static void dump(const Json::object &values, string &out) {
+template <typename Members>
+static void dump_members(const Members &values, string &out) {
     bool first = true;
     out += "{";
     for (const auto &kv : values) {
@@ -137,10 +177,31 @@ static void dump(const Json::object &values, string &out) {
     out += "}";
 }
 
+static void dump(const Json::object &values, string &out) {
+    dump_members(values, out);
+}
+
+static void dump(const flat_object &values, string &out) {
+    dump_members(values, out);
+}
+
 void Json::dump(string &out) const {
     m_ptr->dump(out);
 }
 
+// Documented in json11.hpp
+void dump_string(const string &value, string &out) {
+    dump(value, out);
+}
+
+void dump_number(int value, string &out) {
+    dump(value, out);
+}
+
+void dump_number(double value, string &out) {
+    dump(value, out);
+}
+
 /* * * * * * * * * * * * * * * * * * * *
  * Value wrappers
  */
@@ -209,14 +270,64 @@ public:
     explicit JsonArray(Json::array &&value)      : Value(move(value)) {}
 };
 
+/* Member-wise comparison of objects that may be stored differently (std::map or
+ * flat_object); both are ordered by key, so this matches std::map's own operators.
+ */
+struct MemberEqual {
+    template <typename A, typename B>
+    bool operator()(const A &a, const B &b) const {
+        return a.first == b.first && a.second == b.second;
+    }
+};
+
+struct MemberLess {
+    template <typename A, typename B>
+    bool operator()(const A &a, const B &b) const {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    }
+};
+
+template <typename A, typename B>
+static bool members_equal(const A &a, const B &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), MemberEqual());
+}
+
+template <typename A, typename B>
+static bool members_less(const A &a, const B &b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), MemberLess());
+}
+
+class JsonFlatObject;
+
 class JsonObject final : public Value<Json::OBJECT, Json::object> {
     const Json::object &object_items() const override { return m_value; }
     const Json & operator[](const string &key) const override;
+    bool equals(const JsonValue * other) const override;
+    bool less(const JsonValue * other) const override;
 public:
     explicit JsonObject(const Json::object &value) : Value(value) {}
     explicit JsonObject(Json::object &&value)      : Value(move(value)) {}
 };
 
+/* JsonFlatObject
+ *
+ * Object representation chosen by the parser for objects of at most small_object_size
+ * members: one contiguous allocation and a linear key search instead of a tree node per
+ * member. object_items() builds the equivalent std::map on first use.
+ */
+class JsonFlatObject final : public Value<Json::OBJECT, flat_object> {
+    const Json::object &object_items() const override;
+    const Json & operator[](const string &key) const override;
+    bool equals(const JsonValue * other) const override;
+    bool less(const JsonValue * other) const override;
+
+    mutable std::once_flag m_items_once;
+    mutable std::unique_ptr<Json::object> m_items;
+public:
+    explicit JsonFlatObject(flat_object &&value) : Value(move(value)) {}
+    const flat_object &members() const { return m_value; }
+};
+
 class JsonNull final : public Value<Json::NUL, NullStruct> {
 public:
     JsonNull() : Value({}) {}
@@ -263,6 +374,102 @@ Json::Json(Json::array &&values)       : m_ptr(make_shared<JsonArray>(move(value
 Json::Json(const Json::object &values) : m_ptr(make_shared<JsonObject>(values)) {}
 Json::Json(Json::object &&values)      : m_ptr(make_shared<JsonObject>(move(values))) {}
 
+/* * * * * * * * * * * * * * * * * * * *
+ * Arena storage
+ */
+
+/* JsonArena
+ *
+ * Bump allocator for the values of one JsonDocument. Values are placement-constructed into
+ * blocks and referenced through shared_ptrs that own nothing, so copying them touches no
+ * reference count; the document owns the arena and bounds the lifetime of all of them.
+ */
+class JsonArena final {
+public:
+    JsonArena() : m_next(nullptr), m_left(0), m_block_size(arena_first_block), m_last_size(0) {}
+
+    ~JsonArena() {
+        destroy_values();
+        for (char *block : m_blocks)
+            ::operator delete(block);
+    }
+
+    /* reset()
+     *
+     * Destroy every value and free all blocks but the last, which is the largest; the next
+     * values are built in it. A JsonDocument that parses many small documents in turn thus
+     * allocates no memory once its arena has grown to fit them.
+     */
+    void reset() {
+        destroy_values();
+        if (m_blocks.empty())
+            return;
+        for (size_t k = 0; k + 1 < m_blocks.size(); k++)
+            ::operator delete(m_blocks[k]);
+        m_blocks.front() = m_blocks.back();
+        m_blocks.resize(1);
+        m_next = m_blocks.front();
+        m_left = m_last_size;
+    }
+
+    JsonArena(const JsonArena &) = delete;
+    JsonArena &operator=(const JsonArena &) = delete;
+
+    template <typename V, typename T>
+    Json make(T &&value) {
+        void *memory = allocate(sizeof(V));
+        // Numbers own no memory of their own; everything else is destroyed with the arena.
+        bool destroy = !std::is_same<V, JsonInt>::value && !std::is_same<V, JsonDouble>::value;
+        if (destroy && m_values.size() == m_values.capacity())
+            m_values.reserve(std::max<size_t>(64, 2 * m_values.capacity()));
+        V *ptr = new (memory) V(std::forward<T>(value));
+        if (destroy)
+            m_values.push_back(ptr);
+        return Json(std::shared_ptr<JsonValue>(std::shared_ptr<JsonValue>(), ptr));
+    }
+
+    /* make_on_heap<V>(value)
+     *
+     * Build a value with its own reference-counted allocation, for Json::parse().
+     */
+    template <typename V, typename T>
+    static Json make_on_heap(T &&value) {
+        return Json(std::shared_ptr<JsonValue>(make_shared<V>(std::forward<T>(value))));
+    }
+
+private:
+    void destroy_values() {
+        for (auto it = m_values.rbegin(); it != m_values.rend(); ++it)
+            (*it)->~JsonValue();
+        m_values.clear();
+    }
+
+    void *allocate(size_t size) {
+        const size_t align = alignof(std::max_align_t);
+        size = (size + align - 1) & ~(align - 1);
+        if (size > m_left) {
+            size_t block_size = std::max(m_block_size, size);
+            m_blocks.push_back(nullptr);
+            m_blocks.back() = static_cast<char *>(::operator new(block_size));
+            m_next = m_blocks.back();
+            m_left = block_size;
+            m_last_size = block_size;
+            m_block_size = std::min(m_block_size * 2, arena_max_block);
+        }
+        void *memory = m_next;
+        m_next += size;
+        m_left -= size;
+        return memory;
+    }
+
+    char *m_next;
+    size_t m_left;
+    size_t m_block_size;
+    size_t m_last_size;
+    vector<char *> m_blocks;
+    vector<JsonValue *> m_values;
+};
+
 /* * * * * * * * * * * * * * * * * * * *
  * Accessors
  */
@@ -290,6 +497,41 @@ const Json & JsonObject::operator[] (const string &key) const {
     auto iter = m_value.find(key);
     return (iter == m_value.end()) ? static_null() : iter->second;
 }
+bool JsonObject::equals(const JsonValue * other) const {
+    if (auto flat = dynamic_cast<const JsonFlatObject *>(other))
+        return members_equal(m_value, flat->members());
+    return members_equal(m_value, other->object_items());
+}
+bool JsonObject::less(const JsonValue * other) const {
+    if (auto flat = dynamic_cast<const JsonFlatObject *>(other))
+        return members_less(m_value, flat->members());
+    return members_less(m_value, other->object_items());
+}
+
+const Json::object & JsonFlatObject::object_items() const {
+    std::call_once(m_items_once, [this] {
+        m_items.reset(new Json::object(m_value.begin(), m_value.end()));
+    });
+    return *m_items;
+}
+const Json & JsonFlatObject::operator[] (const string &key) const {
+    for (const auto &member : m_value) {
+        if (member.first == key)
+            return member.second;
+    }
+    return static_null();
+}
+bool JsonFlatObject::equals(const JsonValue * other) const {
+    if (auto flat = dynamic_cast<const JsonFlatObject *>(other))
+        return members_equal(m_value, flat->m_value);
+    return members_equal(m_value, other->object_items());
+}
+bool JsonFlatObject::less(const JsonValue * other) const {
+    if (auto flat = dynamic_cast<const JsonFlatObject *>(other))
+        return members_less(m_value, flat->m_value);
+    return members_less(m_value, other->object_items());
+}
+
 const Json & JsonArray::operator[] (size_t i) const {
     if (i >= m_value.size()) return static_null();
     else return m_value[i];
@@ -339,7 +581,154 @@ static inline bool in_range(long x, long lower, long upper) {
     return (x >= lower && x <= upper);
 }
 
+static inline bool is_whitespace(char c) {
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Scanning
+ *
+ * Each scanner returns the length of the run at the start of p[0..n) made of whitespace
+ * (scan_whitespace) or of string characters that need no special handling: anything but
+ * '"', '\\' and control characters (scan_string). Vector versions are picked at run time
+ * from the features of the CPU.
+ */
+
+static size_t scan_whitespace_scalar(const char *p, size_t n) {
+    size_t k = 0;
+    while (k < n && is_whitespace(p[k]))
+        k++;
+    return k;
+}
+
+static size_t scan_string_scalar(const char *p, size_t n) {
+    size_t k = 0;
+    while (k < n && p[k] != '"' && p[k] != '\\' && static_cast<uint8_t>(p[k]) >= 0x20)
+        k++;
+    return k;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define JSON11_X86_SCAN 1
+#include <immintrin.h>
+
+static size_t scan_whitespace_sse2(const char *p, size_t n) {
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + k));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        unsigned other = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xffff;
+        if (other)
+            return k + __builtin_ctz(other);
+    }
+    return k + scan_whitespace_scalar(p + k, n - k);
+}
+
+static size_t scan_string_sse2(const char *p, size_t n) {
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + k));
+        // Bytes <= 0x1f are those left unchanged by an unsigned max with 0x1f.
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f));
+        __m128i special = _mm_or_si128(
+            control,
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask)
+            return k + __builtin_ctz(mask);
+    }
+    return k + scan_string_scalar(p + k, n - k);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_whitespace_avx2(const char *p, size_t n) {
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + k));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        unsigned other = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (other)
+            return k + __builtin_ctz(other);
+    }
+    return k + scan_whitespace_sse2(p + k, n - k);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_string_avx2(const char *p, size_t n) {
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + k));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1f)),
+                                            _mm256_set1_epi8(0x1f));
+        __m256i special = _mm256_or_si256(
+            control,
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        if (mask)
+            return k + __builtin_ctz(mask);
+    }
+    return k + scan_string_sse2(p + k, n - k);
+}
+#endif
+
+struct Scanners {
+    size_t (*whitespace)(const char *p, size_t n);
+    size_t (*string)(const char *p, size_t n);
+};
+
+static Scanners select_scanners() {
+#ifdef JSON11_X86_SCAN
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return { scan_whitespace_avx2, scan_string_avx2 };
+    return { scan_whitespace_sse2, scan_string_sse2 };
+#else
+    return { scan_whitespace_scalar, scan_string_scalar };
+#endif
+}
+
+static const Scanners & scanners() {
+    static const Scanners s = select_scanners();
+    return s;
+}
+
 namespace {
+/* JsonInput
+ *
+ * Read-only view of the text being parsed, which need not be NUL-terminated (it may be a
+ * memory-mapped file). Like std::string, reading at or past the end yields '\0', so the
+ * parser's one-character lookaheads stay valid.
+ */
+struct JsonInput final {
+    const char *data;
+    size_t length;
+
+    char operator[](size_t pos) const {
+        return pos < length ? data[pos] : '\0';
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    int compare(size_t pos, size_t len, const string &other) const {
+        return substr(pos, len).compare(other);
+    }
+
+    string substr(size_t pos, size_t len) const {
+        if (pos >= length)
+            return string();
+        return string(data + pos, std::min(len, length - pos));
+    }
+};
+
 /* JsonParser
  *
  * Object that tracks all state of an in-progress parse.
@@ -348,11 +737,12 @@ struct JsonParser final {
 
     /* State
      */
-    const string &str;
+    const JsonInput str;
     size_t i;
     string &err;
     bool failed;
     const JsonParse strategy;
+    JsonArena *arena;
 
     /* fail(msg, err_ret = Json())
      *
@@ -370,13 +760,62 @@ struct JsonParser final {
         return err_ret;
     }
 
+    /* make<V>(value)
+     *
+     * Build a parsed value of type V, in the arena if there is one.
+     */
+    template <typename V, typename T>
+    Json make(T &&value) {
+        if (arena)
+            return arena->make<V>(std::forward<T>(value));
+        return JsonArena::make_on_heap<V>(std::forward<T>(value));
+    }
+
+    /* make_object(members)
+     *
+     * Build a parsed object from its members in input order. A key given more than once
+     * keeps its last value. Small objects stay flat; larger ones become a std::map.
+     */
+    Json make_object(flat_object &&members) {
+        if (members.size() > small_object_size) {
+            map<string, Json> data;
+            for (auto &member : members)
+                data[move(member.first)] = move(member.second);
+            return make<JsonObject>(move(data));
+        }
+
+        auto key_not_less = [](const flat_object::value_type &a, const flat_object::value_type &b) {
+            return !(a.first < b.first);
+        };
+        if (std::adjacent_find(members.begin(), members.end(), key_not_less) != members.end()) {
+            std::stable_sort(members.begin(), members.end(),
+                             [](const flat_object::value_type &a, const flat_object::value_type &b) {
+                                 return a.first < b.first;
+                             });
+            size_t kept = 0;
+            for (size_t j = 0; j < members.size(); j++) {
+                if (kept > 0 && members[kept - 1].first == members[j].first)
+                    kept--;
+                if (kept != j)
+                    members[kept] = move(members[j]);
+                kept++;
+            }
+            members.resize(kept);
+        }
+        return make<JsonFlatObject>(move(members));
+    }
+
     /* consume_whitespace()
      *
      * Advance until the current character is non-whitespace.
      */
     void consume_whitespace() {
-        while (str[i] == ' ' || str[i] == '\r' || str[i] == '\n' || str[i] == '\t')
-            i++;
+        if (!is_whitespace(str[i]))
+            return;
+        // Most runs are a single separator; only longer ones go to the vector scanner.
+        i++;
+        if (is_whitespace(str[i]))
+            i += scanners().whitespace(str.data + i, str.size() - i);
     }
 
     /* consume_comment()
@@ -481,6 +920,14 @@ struct JsonParser final {
         string out;
         long last_escaped_codepoint = -1;
         while (true) {
+            size_t run = scanners().string(str.data + i, str.size() - i);
+            if (run > 0) {
+                encode_utf8(last_escaped_codepoint, out);
+                last_escaped_codepoint = -1;
+                out.append(str.data + i, run);
+                i += run;
+            }
+
             if (i == str.size())
                 return fail("unexpected end of input in string", "");
 
@@ -571,7 +1018,23 @@ struct JsonParser final {
      * Parse a double.
      */
     Json parse_number() {
+        double value;
+        bool integral;
+        if (!scan_number(value, integral))
+            return Json();
+        if (integral)
+            return make<JsonInt>(static_cast<int>(value));
+        return make<JsonDouble>(value);
+    }
+
+    /* scan_number(value, integral)
+     *
+     * Parse a number into value, setting integral if it fits an int and has no fraction or
+     * exponent part. Return false if the number is malformed.
+     */
+    bool scan_number(double &value, bool &integral) {
         size_t start_pos = i;
+        integral = false;
 
         if (str[i] == '-')
             i++;
@@ -580,25 +1043,33 @@ struct JsonParser final {
         if (str[i] == '0') {
             i++;
             if (in_range(str[i], '0', '9'))
-                return fail("leading 0s not permitted in numbers");
+                return fail("leading 0s not permitted in numbers", false);
         } else if (in_range(str[i], '1', '9')) {
             i++;
             while (in_range(str[i], '0', '9'))
                 i++;
         } else {
-            return fail("invalid " + esc(str[i]) + " in number");
+            return fail("invalid " + esc(str[i]) + " in number", false);
         }
 
         if (str[i] != '.' && str[i] != 'e' && str[i] != 'E'
                 && (i - start_pos) <= static_cast<size_t>(std::numeric_limits<int>::digits10)) {
-            return std::atoi(str.c_str() + start_pos);
+#ifdef JSON11_CHARCONV
+            int parsed = 0;
+            std::from_chars(str.data + start_pos, str.data + i, parsed);
+            value = parsed;
+#else
+            value = std::atoi(number_text(start_pos).c_str());
+#endif
+            integral = true;
+            return true;
         }
 
         // Decimal part
         if (str[i] == '.') {
             i++;
             if (!in_range(str[i], '0', '9'))
-                return fail("at least one digit required in fractional part");
+                return fail("at least one digit required in fractional part", false);
 
             while (in_range(str[i], '0', '9'))
                 i++;
@@ -612,13 +1083,29 @@ struct JsonParser final {
                 i++;
 
             if (!in_range(str[i], '0', '9'))
-                return fail("at least one digit required in exponent");
+                return fail("at least one digit required in exponent", false);
 
             while (in_range(str[i], '0', '9'))
                 i++;
         }
 
-        return std::strtod(str.c_str() + start_pos, nullptr);
+#ifdef JSON11_CHARCONV
+        // from_chars leaves value untouched when it overflows; strtod gives +/-HUGE_VAL or 0.
+        if (std::from_chars(str.data + start_pos, str.data + i, value).ec == std::errc())
+            return true;
+#endif
+        value = std::strtod(number_text(start_pos).c_str(), nullptr);
+        return true;
+    }
+
+    /* number_text(start_pos)
+     *
+     * Return the number just scanned as a NUL-terminated string for atoi()/strtod(); the
+     * input itself may not be terminated. Only needed without std::from_chars, or when it
+     * reports a value out of range.
+     */
+    string number_text(size_t start_pos) const {
+        return str.substr(start_pos, i - start_pos);
     }
 
     /* expect(str, res)
@@ -665,13 +1152,13 @@ struct JsonParser final {
             return expect("null", Json());
 
         if (ch == '"')
-            return parse_string();
+            return make<JsonString>(parse_string());
 
         if (ch == '{') {
-            map<string, Json> data;
+            flat_object data;
             ch = get_next_token();
             if (ch == '}')
-                return data;
+                return make_object(move(data));
 
             while (1) {
                 if (ch != '"')
@@ -685,7 +1172,7 @@ struct JsonParser final {
                 if (ch != ':')
                     return fail("expected ':' in object, got " + esc(ch));
 
-                data[std::move(key)] = parse_json(depth + 1);
+                data.emplace_back(move(key), parse_json(depth + 1));
                 if (failed)
                     return Json();
 
@@ -697,14 +1184,14 @@ struct JsonParser final {
 
                 ch = get_next_token();
             }
-            return data;
+            return make_object(move(data));
         }
 
         if (ch == '[') {
             vector<Json> data;
             ch = get_next_token();
             if (ch == ']')
-                return data;
+                return make<JsonArray>(move(data));
 
             while (1) {
                 i--;
@@ -721,34 +1208,192 @@ struct JsonParser final {
                 ch = get_next_token();
                 (void)ch;
             }
-            return data;
+            return make<JsonArray>(move(data));
         }
 
         return fail("expected value, got " + esc(ch));
     }
+
+    /* parse_sax(depth, handler)
+     *
+     * Parse a JSON value, reporting it to handler instead of building a Json. Mirrors
+     * parse_json() token for token.
+     */
+    bool parse_sax(int depth, JsonSax &handler) {
+        if (depth > max_depth) {
+            return fail("exceeded maximum nesting depth", false);
+        }
+
+        char ch = get_next_token();
+        if (failed)
+            return false;
+
+        if (ch == '-' || (ch >= '0' && ch <= '9')) {
+            i--;
+            double value;
+            bool integral;
+            if (!scan_number(value, integral))
+                return false;
+            return accept(handler.number_value(value));
+        }
+
+        if (ch == 't')
+            return expect_literal("true") && accept(handler.bool_value(true));
+
+        if (ch == 'f')
+            return expect_literal("false") && accept(handler.bool_value(false));
+
+        if (ch == 'n')
+            return expect_literal("null") && accept(handler.null_value());
+
+        if (ch == '"') {
+            string value = parse_string();
+            if (failed)
+                return false;
+            return accept(handler.string_value(move(value)));
+        }
+
+        if (ch == '{') {
+            if (!accept(handler.start_object()))
+                return false;
+            ch = get_next_token();
+            if (ch == '}')
+                return accept(handler.end_object());
+
+            while (1) {
+                if (ch != '"')
+                    return fail("expected '\"' in object, got " + esc(ch), false);
+
+                string key = parse_string();
+                if (failed || !accept(handler.key(move(key))))
+                    return false;
+
+                ch = get_next_token();
+                if (ch != ':')
+                    return fail("expected ':' in object, got " + esc(ch), false);
+
+                if (!parse_sax(depth + 1, handler))
+                    return false;
+
+                ch = get_next_token();
+                if (ch == '}')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in object, got " + esc(ch), false);
+
+                ch = get_next_token();
+            }
+            return accept(handler.end_object());
+        }
+
+        if (ch == '[') {
+            if (!accept(handler.start_array()))
+                return false;
+            ch = get_next_token();
+            if (ch == ']')
+                return accept(handler.end_array());
+
+            while (1) {
+                i--;
+                if (!parse_sax(depth + 1, handler))
+                    return false;
+
+                ch = get_next_token();
+                if (ch == ']')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in list, got " + esc(ch), false);
+
+                ch = get_next_token();
+                (void)ch;
+            }
+            return accept(handler.end_array());
+        }
+
+        return fail("expected value, got " + esc(ch), false);
+    }
+
+    /* expect_literal(str)
+     *
+     * Like expect(), for parse_sax(): no Json result is built.
+     */
+    bool expect_literal(const string &expected) {
+        assert(i != 0);
+        i--;
+        if (str.compare(i, expected.length(), expected) == 0) {
+            i += expected.length();
+            return true;
+        } else {
+            return fail("parse error: expected " + expected + ", got " + str.substr(i, expected.length()), false);
+        }
+    }
+
+    /* accept(ok)
+     *
+     * Flag an error if a JsonSax callback asked to stop the parse.
+     */
+    bool accept(bool ok) {
+        if (!ok)
+            return fail("parse aborted by handler", false);
+        return true;
+    }
 };
 }//namespace {
 
-Json Json::parse(const string &in, string &err, JsonParse strategy) {
-    JsonParser parser { in, 0, err, false, strategy };
+/* parse_document(in, len, err, strategy, arena)
+ *
+ * Parse one whole document, into arena if it is not null.
+ */
+static Json parse_document(const char *in, size_t len, string &err, JsonParse strategy,
+                           JsonArena *arena) {
+    JsonParser parser { { in, len }, 0, err, false, strategy, arena };
     Json result = parser.parse_json(0);
 
     // Check for any trailing garbage
     parser.consume_garbage();
     if (parser.failed)
         return Json();
-    if (parser.i != in.size())
+    if (parser.i != len)
         return parser.fail("unexpected trailing " + esc(in[parser.i]));
 
     return result;
 }
 
+Json Json::parse(const string &in, string &err, JsonParse strategy) {
+    return parse(in.data(), in.size(), err, strategy);
+}
+
+Json Json::parse(const char *in, size_t len, string &err, JsonParse strategy) {
+    return parse_document(in, len, err, strategy, nullptr);
+}
+
+JsonDocument::JsonDocument() {}
+
+JsonDocument::~JsonDocument() {}
+
+bool JsonDocument::parse(const char *in, size_t len, string &err, JsonParse strategy) {
+    // Drop the values of the previous contents before the arena they live in.
+    m_root = Json();
+    if (m_arena)
+        m_arena->reset();
+    else
+        m_arena.reset(new JsonArena);
+    err.clear();
+    m_root = parse_document(in, len, err, strategy, m_arena.get());
+    if (!err.empty()) {
+        m_root = Json();
+        m_arena->reset();
+        return false;
+    }
+    return true;
+}
+
 // Documented in json11.hpp
 vector<Json> Json::parse_multi(const string &in,
                                std::string::size_type &parser_stop_pos,
                                string &err,
                                JsonParse strategy) {
-    JsonParser parser { in, 0, err, false, strategy };
+    JsonParser parser { { in.data(), in.size() }, 0, err, false, strategy, nullptr };
     parser_stop_pos = 0;
     vector<Json> json_vec;
     while (parser.i != in.size() && !parser.failed) {
@@ -765,6 +1410,324 @@ vector<Json> Json::parse_multi(const string &in,
     return json_vec;
 }
 
+// Documented in json11.hpp
+bool Json::parse_sax(const string &in, JsonSax &handler, string &err, JsonParse strategy) {
+    return parse_sax(in.data(), in.size(), handler, err, strategy);
+}
+
+bool Json::parse_sax(const char *in, size_t len, JsonSax &handler, string &err,
+                     JsonParse strategy) {
+    JsonParser parser { { in, len }, 0, err, false, strategy, nullptr };
+    if (!parser.parse_sax(0, handler))
+        return false;
+
+    // Check for any trailing garbage
+    parser.consume_garbage();
+    if (parser.failed)
+        return false;
+    if (parser.i != len)
+        return parser.fail("unexpected trailing " + esc(in[parser.i]), false);
+
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Incremental parsing
+ */
+
+/* JsonPushParser::State
+ *
+ * Containers above split_depth are tracked on a stack, with the grammar position in expect.
+ * Any other token - a scalar above split_depth, an object key, or a whole value at
+ * split_depth - is first collected in capture and then handed to Json::parse, which does the
+ * full validation and decoding. Everything but keys is queued.
+ */
+struct JsonPushParser::State {
+    enum Expect {
+        EXPECT_VALUE, EXPECT_VALUE_OR_CLOSE, EXPECT_KEY, EXPECT_KEY_OR_CLOSE, EXPECT_COLON,
+        EXPECT_COMMA_OR_CLOSE
+    };
+    enum Capture {
+        CAPTURE_NONE, CAPTURE_STRING, CAPTURE_CONTAINER, CAPTURE_BARE
+    };
+
+    const size_t split_depth;
+
+    Expect expect = EXPECT_VALUE;
+    vector<char> containers;
+    vector<string> keys;
+
+    Capture capture = CAPTURE_NONE;
+    string text;
+    bool is_key = false;
+    bool emit = false;
+    bool in_string = false;
+    bool escaped = false;
+    size_t nesting = 0;
+
+    std::deque<std::pair<Json, vector<Json>>> ready;
+    bool complete = false;
+    bool failed = false;
+    string error;
+
+    explicit State(int split_depth)
+        : split_depth(split_depth > 0 ? split_depth : 0) {}
+
+    bool fail(string &&msg) {
+        if (!failed)
+            error = move(msg);
+        failed = true;
+        return false;
+    }
+
+    /* feed(in, len)
+     *
+     * Advance over len bytes of input.
+     */
+    bool feed(const char *in, size_t len) {
+        size_t i = 0;
+        while (i < len && !failed) {
+            if (capture != CAPTURE_NONE)
+                i += consume_capture(in + i, len - i);
+            else
+                consume_token(in[i++]);
+        }
+        return !failed;
+    }
+
+    bool finish() {
+        if (failed)
+            return false;
+        if (capture == CAPTURE_BARE)
+            complete_capture();
+        if (failed)
+            return false;
+        if (capture != CAPTURE_NONE || !complete)
+            return fail("unexpected end of input");
+        return true;
+    }
+
+    /* consume_capture(in, len)
+     *
+     * Append the bytes of the token being captured, up to its end; return how many were used.
+     */
+    size_t consume_capture(const char *in, size_t len) {
+        size_t k = 0;
+        if (capture == CAPTURE_BARE) {
+            while (k < len && !is_delimiter(in[k]))
+                k++;
+            text.append(in, k);
+            if (k < len)
+                complete_capture();
+            return k;
+        }
+
+        while (k < len) {
+            char ch = in[k++];
+            if (in_string) {
+                if (escaped) {
+                    escaped = false;
+                } else if (ch == '\\') {
+                    escaped = true;
+                } else if (ch == '"') {
+                    in_string = false;
+                    if (capture == CAPTURE_STRING) {
+                        text.append(in, k);
+                        complete_capture();
+                        return k;
+                    }
+                } else {
+                    // Skip ahead over the plain bytes of a long string.
+                    k += scanners().string(in + k, len - k);
+                }
+            } else if (ch == '"') {
+                in_string = true;
+            } else if (ch == '{' || ch == '[') {
+                nesting++;
+            } else if (ch == '}' || ch == ']') {
+                if (--nesting == 0) {
+                    text.append(in, k);
+                    complete_capture();
+                    return k;
+                }
+            }
+        }
+        text.append(in, k);
+        return k;
+    }
+
+    static bool is_delimiter(char ch) {
+        return is_whitespace(ch) || ch == ',' || ch == ':' || ch == ']' || ch == '}'
+            || ch == '[' || ch == '{' || ch == '"';
+    }
+
+    /* consume_token(ch)
+     *
+     * Handle one byte outside any capture.
+     */
+    void consume_token(char ch) {
+        if (is_whitespace(ch))
+            return;
+        if (complete) {
+            fail("unexpected trailing " + esc(ch));
+            return;
+        }
+
+        switch (expect) {
+        case EXPECT_VALUE_OR_CLOSE:
+            if (ch == ']') {
+                close_container(ch);
+                return;
+            }
+            start_value(ch);
+            return;
+        case EXPECT_VALUE:
+            start_value(ch);
+            return;
+        case EXPECT_KEY_OR_CLOSE:
+            if (ch == '}') {
+                close_container(ch);
+                return;
+            }
+            // fall through
+        case EXPECT_KEY:
+            if (ch != '"') {
+                fail("expected '\"' in object, got " + esc(ch));
+                return;
+            }
+            start_capture(CAPTURE_STRING, ch, true, false);
+            return;
+        case EXPECT_COLON:
+            if (ch != ':') {
+                fail("expected ':' in object, got " + esc(ch));
+                return;
+            }
+            expect = EXPECT_VALUE;
+            return;
+        case EXPECT_COMMA_OR_CLOSE:
+            if (ch == ',') {
+                expect = containers.back() == '{' ? EXPECT_KEY : EXPECT_VALUE;
+            } else if (ch == '}' || ch == ']') {
+                close_container(ch);
+            } else if (containers.back() == '{') {
+                fail("expected ',' in object, got " + esc(ch));
+            } else {
+                fail("expected ',' in list, got " + esc(ch));
+            }
+            return;
+        }
+    }
+
+    void start_value(char ch) {
+        bool at_split = containers.size() >= split_depth;
+        if (ch == '{' || ch == '[') {
+            if (at_split) {
+                nesting = 1;
+                start_capture(CAPTURE_CONTAINER, ch, false, true);
+            } else {
+                containers.push_back(ch);
+                keys.push_back(string());
+                expect = ch == '{' ? EXPECT_KEY_OR_CLOSE : EXPECT_VALUE_OR_CLOSE;
+            }
+        } else if (ch == '"') {
+            start_capture(CAPTURE_STRING, ch, false, true);
+        } else if (ch == '-' || in_range(ch, '0', '9') || in_range(ch, 'a', 'z')) {
+            start_capture(CAPTURE_BARE, ch, false, true);
+        } else {
+            fail("expected value, got " + esc(ch));
+        }
+    }
+
+    void start_capture(Capture kind, char first, bool key, bool emit_value) {
+        capture = kind;
+        text.assign(1, first);
+        is_key = key;
+        emit = emit_value;
+        in_string = first == '"';
+        escaped = false;
+    }
+
+    void close_container(char ch) {
+        char open = containers.back();
+        if ((open == '{') != (ch == '}')) {
+            fail(open == '{' ? "expected ',' in object, got " + esc(ch)
+                             : "expected ',' in list, got " + esc(ch));
+            return;
+        }
+        containers.pop_back();
+        keys.pop_back();
+        value_done();
+    }
+
+    void value_done() {
+        expect = EXPECT_COMMA_OR_CLOSE;
+        if (containers.empty())
+            complete = true;
+    }
+
+    void complete_capture() {
+        capture = CAPTURE_NONE;
+        string err;
+        Json value = Json::parse(text, err);
+        text.clear();
+        if (!err.empty()) {
+            fail(move(err));
+            return;
+        }
+
+        if (is_key) {
+            keys.back() = value.string_value();
+            expect = EXPECT_COLON;
+            return;
+        }
+        if (emit)
+            ready.emplace_back(move(value), path());
+        value_done();
+    }
+
+    vector<Json> path() const {
+        vector<Json> result;
+        result.reserve(containers.size());
+        for (size_t k = 0; k < containers.size(); k++) {
+            if (containers[k] == '{')
+                result.emplace_back(keys[k]);
+            else
+                result.emplace_back(nullptr);
+        }
+        return result;
+    }
+};
+
+JsonPushParser::JsonPushParser(int split_depth)
+    : m_state(new State(split_depth)) {}
+
+JsonPushParser::~JsonPushParser() {}
+
+bool JsonPushParser::feed(const char *in, size_t len, string &err) {
+    if (!m_state->feed(in, len)) {
+        err = m_state->error;
+        return false;
+    }
+    return true;
+}
+
+bool JsonPushParser::finish(string &err) {
+    if (!m_state->finish()) {
+        err = m_state->error;
+        return false;
+    }
+    return true;
+}
+
+bool JsonPushParser::next(Json &value, vector<Json> &path) {
+    if (m_state->ready.empty())
+        return false;
+    value = move(m_state->ready.front().first);
+    path = move(m_state->ready.front().second);
+    m_state->ready.pop_front();
+    return true;
+}
+
 /* * * * * * * * * * * * * * * * * * * *
  * Shape-checking
  */
@@ -55,6 +55,7 @@
 #include <map>
 #include <memory>
 #include <initializer_list>
+#include <deque>
 
 #ifdef _MSC_VER
     #if _MSC_VER <= 1800 // VS 2013
@@ -75,6 +76,8 @@ enum JsonParse {
 };
 
 class JsonValue;
+class JsonSax;
+class JsonArena;
 
 class Json final {
 public:
@@ -174,6 +177,11 @@ public:
             return nullptr;
         }
     }
+    // Parse len bytes at in, which need not be NUL-terminated (e.g. a memory-mapped file).
+    static Json parse(const char * in,
+                      size_t len,
+                      std::string & err,
+                      JsonParse strategy = JsonParse::STANDARD);
     // Parse multiple objects, concatenated or separated by whitespace
     static std::vector<Json> parse_multi(
         const std::string & in,
@@ -189,6 +197,19 @@ public:
         return parse_multi(in, parser_stop_pos, err, strategy);
     }
 
+    // Parse without building a Json tree: every value is reported to the handler as it is
+    // read. Return false and assign an error message to err if the parse fails or if the
+    // handler aborts it.
+    static bool parse_sax(const std::string & in,
+                          JsonSax & handler,
+                          std::string & err,
+                          JsonParse strategy = JsonParse::STANDARD);
+    static bool parse_sax(const char * in,
+                          size_t len,
+                          JsonSax & handler,
+                          std::string & err,
+                          JsonParse strategy = JsonParse::STANDARD);
+
     bool operator== (const Json &rhs) const;
     bool operator<  (const Json &rhs) const;
     bool operator!= (const Json &rhs) const { return !(*this == rhs); }
@@ -205,15 +226,114 @@ public:
     bool has_shape(const shape & types, std::string & err) const;
 
 private:
+    friend class JsonArena;
+    friend class JsonDocument;
+    explicit Json(std::shared_ptr<JsonValue> ptr) : m_ptr(std::move(ptr)) {}
+
     std::shared_ptr<JsonValue> m_ptr;
 };
 
+// Append value to out exactly as Json::dump() would format it, without constructing a Json.
+// For writers that stream a document instead of building it as a Json tree.
+void dump_string(const std::string &value, std::string &out);
+void dump_number(int value, std::string &out);
+void dump_number(double value, std::string &out);
+
+/* JsonDocument
+ *
+ * A document parsed into arena storage: its values are placement-constructed into blocks
+ * owned by the JsonDocument and freed together with it, so that parsing costs no allocation
+ * or reference count per value. Values read out of the document, and copies of them, refer
+ * into the arena and must not be used after the document is destroyed or parses again;
+ * use Json::parse() for values that are to outlive the document. The arena's memory is kept
+ * from one parse to the next, so a document reused for a run of small inputs, such as the
+ * lines of a log, stops allocating value nodes once it has grown to fit them.
+ */
+class JsonDocument final {
+public:
+    JsonDocument();
+    ~JsonDocument();
+
+    JsonDocument(const JsonDocument &) = delete;
+    JsonDocument &operator=(const JsonDocument &) = delete;
+
+    // Parse len bytes at in, replacing the previous contents. If parse fails, root() is
+    // Json() and an error message is assigned to err.
+    bool parse(const char * in,
+               size_t len,
+               std::string & err,
+               JsonParse strategy = JsonParse::STANDARD);
+    const Json & root() const { return m_root; }
+
+private:
+    std::unique_ptr<JsonArena> m_arena;
+    Json m_root;
+};
+
+/* JsonSax
+ *
+ * Event receiver for Json::parse_sax(). Callbacks arrive in document order; object members
+ * are reported as key() followed by the events for the member value. Returning false from
+ * any callback stops the parse. The default implementations accept and ignore the event.
+ */
+class JsonSax {
+public:
+    virtual bool null_value()                  { return true; }
+    virtual bool bool_value(bool)              { return true; }
+    virtual bool number_value(double)          { return true; }
+    virtual bool string_value(std::string &&)  { return true; }
+    virtual bool start_array()                 { return true; }
+    virtual bool end_array()                   { return true; }
+    virtual bool start_object()                { return true; }
+    virtual bool key(std::string &&)           { return true; }
+    virtual bool end_object()                  { return true; }
+    virtual ~JsonSax() {}
+};
+
+/* JsonPushParser
+ *
+ * Incremental parser for input that arrives in pieces (pipes, sockets, decompressors). Chunks
+ * are fed as they come; the parser keeps its position between calls and queues every value it
+ * completes at split_depth: whole top-level values for 0, the elements or member values of
+ * top-level containers for 1, and so on. Structure above split_depth is checked but not kept;
+ * scalars found there are queued too, so that members next to the split containers are not
+ * lost. Only JsonParse::STANDARD input is accepted.
+ */
+class JsonPushParser final {
+public:
+    explicit JsonPushParser(int split_depth = 0);
+    ~JsonPushParser();
+
+    JsonPushParser(const JsonPushParser &) = delete;
+    JsonPushParser &operator=(const JsonPushParser &) = delete;
+
+    // Consume len more bytes. Return false, and assign an error message to err, as soon as
+    // the input is known to be invalid, including anything but whitespace after the
+    // top-level value; later calls fail with the same message.
+    bool feed(const char * in, size_t len, std::string & err);
+    // Declare the end of the input. Return false if it ends inside a value or container, or
+    // before the top-level value has begun.
+    bool finish(std::string & err);
+
+    // Take the oldest queued value. path holds one entry per enclosing container, outermost
+    // first: the member key for an object, null for an array. Return false if no value is
+    // ready.
+    bool next(Json & value, std::vector<Json> & path);
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
+
 // Internal class hierarchy - JsonValue objects are not exposed to users of this API.
 class JsonValue {
 protected:
     friend class Json;
+    friend class JsonArena;
     friend class JsonInt;
     friend class JsonDouble;
+    friend class JsonObject;
+    friend class JsonFlatObject;
     virtual Json::Type type() const = 0;
     virtual bool equals(const JsonValue * other) const = 0;
     virtual bool less(const JsonValue * other) const = 0;
@@ -1,38 +1,44 @@
 #include <QtWidgets>
 #include <iostream>
+#include <vector>
 
+#include "edgelayer.h"
+#include "graphmodel.h"
 #include "link.h"
+#include "linkitem.h"
 #include "node.h"
 
 namespace {
-
-Node *find_node(const std::map<int, Node *> &nodeList, int index)
-{
-    auto iter = nodeList.find(index);
-    if (iter == nodeList.end())
-        return NULL;
-    return iter->second;
-}
-
+// Links waiting for trackPendingLinks().
+std::vector<Link *> pendingLinks;
 }
 
 Link::Link(Node *fromNode, Node *toNode)
 {
     myFromNode = fromNode;
     myToNode = toNode;
+    myPendingIndex = -1;
+    myLayer = 0;
+    myItem = 0;
 
     myFromNode->addLink(this);
     myToNode->addLink(this);
 
-    setFlags(QGraphicsItem::ItemIsSelectable);
-    setZValue(-1);
-
     setColor(Qt::darkRed);
     trackNodes();
 }
 
 Link::~Link()
 {
+    if (myPendingIndex >= 0) {
+        Link *last = pendingLinks.back();
+        pendingLinks[myPendingIndex] = last;
+        last->myPendingIndex = myPendingIndex;
+        pendingLinks.pop_back();
+    }
+    if (myLayer)
+        myLayer->removeLink(this);
+    delete myItem;
     myFromNode->removeLink(this);
     myToNode->removeLink(this);
 }
@@ -49,20 +55,93 @@ Node *Link::toNode() const
 
 void Link::setColor(const QColor &color)
 {
-    setPen(QPen(color, 1.0));
+    myColor = color.rgba();
+    if (myItem)
+        myItem->setPen(QPen(color, 1.0));
+    if (myLayer)
+        myLayer->linkChanged(this, myLine);
 }
 
 QColor Link::color() const
 {
-    return pen().color();
+    return QColor::fromRgba(myColor);
+}
+
+QLineF Link::line() const
+{
+    return myLine;
 }
 
 void Link::trackNodes()
 {
-    setLine(QLineF(myFromNode->pos(), myToNode->pos()));
+    QLineF oldLine = myLine;
+    myLine = QLineF(myFromNode->pos(), myToNode->pos());
+    if (myItem)
+        myItem->setLine(myLine);
+    if (myLayer)
+        myLayer->linkChanged(this, oldLine);
+}
+
+// Defers trackNodes() to the next trackPendingLinks(). A link whose nodes
+// move many times in between, or which is marked by both of its nodes, is
+// updated once. Node::mouseMoveEvent() flushes at the end of each drag
+// step; the timer covers moves made in code.
+void Link::trackLater()
+{
+    if (myPendingIndex >= 0)
+        return;
+
+    if (pendingLinks.empty())
+        QTimer::singleShot(0, &Link::trackPendingLinks);
+    myPendingIndex = pendingLinks.size();
+    pendingLinks.push_back(this);
+}
+
+void Link::trackPendingLinks()
+{
+    std::vector<Link *> links;
+    links.swap(pendingLinks);
+    for (Link *link: links) {
+        link->myPendingIndex = -1;
+        link->trackNodes();
+    }
+}
+
+SlotHandle Link::handle() const
+{
+    return myHandle;
+}
+
+void Link::setHandle(SlotHandle handle)
+{
+    myHandle = handle;
+}
+
+// While a link is attached to an edge layer it is drawn and selected by the
+// layer and has no item.
+EdgeLayer *Link::layer() const
+{
+    return myLayer;
+}
+
+void Link::setLayer(EdgeLayer *layer)
+{
+    myLayer = layer;
+}
+
+// The item that shows the link in the scene, if it has one. The link
+// deletes it together with itself.
+LinkItem *Link::item() const
+{
+    return myItem;
 }
 
-Link *Link::newFromJson(json11::Json json, const std::map<int, Node *> &nodeList)
+void Link::setItem(LinkItem *item)
+{
+    myItem = item;
+}
+
+Link *Link::newFromJson(json11::Json json, const GraphModel &model)
 {
     auto from = json["from"];
     if (!from.is_number()) {
@@ -70,7 +149,7 @@ Link *Link::newFromJson(json11::Json json, const std::map<int, Node *> &nodeList
         return NULL;
     }
 
-    auto fromNode = find_node(nodeList, from.int_value());
+    auto fromNode = model.findNode(from.int_value());
     if (!fromNode) {
         std::cerr << "invalid link from index\n";
         return NULL;
@@ -82,7 +161,7 @@ Link *Link::newFromJson(json11::Json json, const std::map<int, Node *> &nodeList
         return NULL;
     }
 
-    auto toNode = find_node(nodeList, to.int_value());
+    auto toNode = model.findNode(to.int_value());
     if (!toNode) {
         std::cerr << "invalid link to index\n";
         return NULL;
@@ -91,6 +170,35 @@ Link *Link::newFromJson(json11::Json json, const std::map<int, Node *> &nodeList
     return new Link(fromNode, toNode);
 }
 
+Link *Link::newFromRecord(const LinkRecord &record, const GraphModel &model)
+{
+    auto fromNode = model.findNode(record.from);
+    if (!fromNode) {
+        std::cerr << "invalid link from index\n";
+        return NULL;
+    }
+
+    auto toNode = model.findNode(record.to);
+    if (!toNode) {
+        std::cerr << "invalid link to index\n";
+        return NULL;
+    }
+
+    Link *link = new Link(fromNode, toNode);
+    if (record.color)
+        link->setColor(QColor::fromRgba(record.color));
+    return link;
+}
+
+LinkRecord Link::toRecord() const
+{
+    LinkRecord record;
+    record.from = fromNode()->index();
+    record.to = toNode()->index();
+    record.color = color().rgba();
+    return record;
+}
+
 json11::Json Link::toJson()
 {
     using json11::Json;
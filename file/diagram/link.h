@@ -1,12 +1,20 @@
 #ifndef LINK_H
 #define LINK_H
 
-#include <QGraphicsLineItem>
+#include <QColor>
+#include <QLineF>
+#include "diagramrecord.h"
 #include "json11.hpp"
+#include "slotmap.h"
 
+class EdgeLayer;
+class GraphModel;
+class LinkItem;
 class Node;
 
-class Link : public QGraphicsLineItem
+// A link between two nodes. Links are not scene items: an edge layer draws
+// them, or else each one has a LinkItem in the scene.
+class Link
 {
 public:
     Link(Node *fromNode, Node *toNode);
@@ -17,15 +25,33 @@ public:
 
     void setColor(const QColor &color);
     QColor color() const;
+    QLineF line() const;
 
     void trackNodes();
-
-    static Link *newFromJson(json11::Json json, const std::map<int, Node *> &nodeList);
+    void trackLater();
+    static void trackPendingLinks();
+
+    SlotHandle handle() const;
+    void setHandle(SlotHandle handle);
+    EdgeLayer *layer() const;
+    void setLayer(EdgeLayer *layer);
+    LinkItem *item() const;
+    void setItem(LinkItem *item);
+
+    static Link *newFromJson(json11::Json json, const GraphModel &model);
+    static Link *newFromRecord(const LinkRecord &record, const GraphModel &model);
+    LinkRecord toRecord() const;
     json11::Json toJson();
 
 private:
     Node *myFromNode;
     Node *myToNode;
+    QLineF myLine;
+    QRgb myColor;
+    int myPendingIndex;
+    SlotHandle myHandle;
+    EdgeLayer *myLayer;
+    LinkItem *myItem;
 };
 
 #endif
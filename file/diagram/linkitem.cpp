@@ -0,0 +1,35 @@
+#include <QtWidgets>
+
+#include "link.h"
+#include "linkitem.h"
+#include "node.h"
+
+LinkItem::LinkItem(Link *link)
+{
+    myLink = link;
+    myLink->setItem(this);
+
+    setFlags(QGraphicsItem::ItemIsSelectable);
+    setZValue(-1);
+    setPen(QPen(link->color(), 1.0));
+    setLine(link->line());
+}
+
+LinkItem::~LinkItem()
+{
+    myLink->setItem(0);
+}
+
+Link *LinkItem::link() const
+{
+    return myLink;
+}
+
+void LinkItem::paint(QPainter *painter,
+                     const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (Node::detailFor(option->levelOfDetailFromTransform(
+                            painter->worldTransform())) == Node::PointDetail)
+        painter->setRenderHint(QPainter::Antialiasing, false);
+    QGraphicsLineItem::paint(painter, option, widget);
+}
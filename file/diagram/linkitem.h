@@ -0,0 +1,26 @@
+#ifndef LINKITEM_H
+#define LINKITEM_H
+
+#include <QGraphicsLineItem>
+
+class Link;
+
+// Shows a link in the scene as an item of its own, for when links are not
+// drawn by an edge layer. The link keeps the item's line and pen up to
+// date.
+class LinkItem : public QGraphicsLineItem
+{
+public:
+    explicit LinkItem(Link *link);
+    ~LinkItem();
+
+    Link *link() const;
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+private:
+    Link *myLink;
+};
+
+#endif
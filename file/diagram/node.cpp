@@ -4,26 +4,44 @@
 #include "link.h"
 #include "node.h"
 
+namespace {
+qreal textDetailLevel = 0.4;
+qreal outlineDetailLevel = 0.2;
+qreal rectDetailLevel = 0.05;
+bool pixmapCaching = false;
+
+const Qt::GlobalColor DEFAULT_TEXT_COLOR = Qt::darkGreen;
+const Qt::GlobalColor DEFAULT_OUTLINE_COLOR = Qt::darkBlue;
+const Qt::GlobalColor DEFAULT_BACKGROUND_COLOR = Qt::white;
+}
+
 Node::Node(int index)
 {
     myIndex = index;
-    myTextColor = Qt::darkGreen;
-    myOutlineColor = Qt::darkBlue;
-    myBackgroundColor = Qt::white;
-
-    setFlags(ItemIsMovable | ItemIsSelectable);
+    myChanges = 0;
+    myTextColor = DEFAULT_TEXT_COLOR;
+    myOutlineColor = DEFAULT_OUTLINE_COLOR;
+    myBackgroundColor = DEFAULT_BACKGROUND_COLOR;
+
+    setFlags(ItemIsMovable | ItemIsSelectable | ItemSendsGeometryChanges);
+    if (pixmapCaching)
+        setCacheMode(DeviceCoordinateCache);
+    updateOutline();
 }
 
+// Each link removes itself from myLinks as it is deleted.
 Node::~Node()
 {
-    foreach (Link *link, myLinks)
-        delete link;
+    while (!myLinks.isEmpty())
+        delete myLinks.last();
 }
 
 void Node::setText(const QString &text)
 {
     prepareGeometryChange();
     myText = text;
+    myChanges |= Renamed;
+    updateOutline();
     update();
 }
 
@@ -40,6 +58,7 @@ QString Node::text() const
 void Node::setTextColor(const QColor &color)
 {
     myTextColor = color;
+    myChanges |= Recolored;
     update();
 }
 
@@ -51,6 +70,7 @@ QColor Node::textColor() const
 void Node::setOutlineColor(const QColor &color)
 {
     myOutlineColor = color;
+    myChanges |= Recolored;
     update();
 }
 
@@ -62,6 +82,7 @@ QColor Node::outlineColor() const
 void Node::setBackgroundColor(const QColor &color)
 {
     myBackgroundColor = color;
+    myChanges |= Recolored;
     update();
 }
 
@@ -70,14 +91,51 @@ QColor Node::backgroundColor() const
     return myBackgroundColor;
 }
 
+// The outline is measured with the application font, so it has to be
+// recomputed when that font changes.
+void Node::fontChanged()
+{
+    prepareGeometryChange();
+    updateOutline();
+    update();
+}
+
+// A combination of Change flags.
+int Node::changes() const
+{
+    return myChanges;
+}
+
+void Node::clearChanges()
+{
+    myChanges = 0;
+}
+
+// A link from a node to itself is added twice in a row; it is kept once.
 void Node::addLink(Link *link)
 {
-    myLinks.insert(link);
+    if (myLinks.isEmpty() || myLinks.last() != link)
+        myLinks.append(link);
 }
 
 void Node::removeLink(Link *link)
 {
-    myLinks.remove(link);
+    myLinks.removeOne(link);
+}
+
+const SmallVector<Link *, 4> &Node::links() const
+{
+    return myLinks;
+}
+
+SlotHandle Node::handle() const
+{
+    return myHandle;
+}
+
+void Node::setHandle(SlotHandle handle)
+{
+    myHandle = handle;
 }
 
 QRectF Node::boundingRect() const
@@ -88,18 +146,21 @@ QRectF Node::boundingRect() const
 
 QPainterPath Node::shape() const
 {
-    QRectF rect = outlineRect();
-
-    QPainterPath path;
-    path.addRoundRect(rect, roundness(rect.width()),
-                      roundness(rect.height()));
-    return path;
+    return myShape;
 }
 
 void Node::paint(QPainter *painter,
                  const QStyleOptionGraphicsItem *option,
                  QWidget * /* widget */)
 {
+    Detail detail = detailFor(option->levelOfDetailFromTransform(
+                                  painter->worldTransform()));
+    if (detail == PointDetail) {
+        painter->setPen(QPen(myOutlineColor, 0));
+        painter->drawPoint(QPointF());
+        return;
+    }
+
     QPen pen(myOutlineColor);
     if (option->state & QStyle::State_Selected) {
         pen.setStyle(Qt::DotLine);
@@ -108,12 +169,17 @@ void Node::paint(QPainter *painter,
     painter->setPen(pen);
     painter->setBrush(myBackgroundColor);
 
-    QRectF rect = outlineRect();
-    painter->drawRoundRect(rect, roundness(rect.width()),
-                           roundness(rect.height()));
+    if (detail == RectDetail) {
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->drawRect(myOutlineRect);
+        return;
+    }
+    painter->drawPath(myShape);
+    if (detail == OutlineDetail)
+        return;
 
     painter->setPen(myTextColor);
-    painter->drawText(rect, Qt::AlignCenter, myText);
+    painter->drawText(myOutlineRect, Qt::AlignCenter, myText);
 }
 
 void Node::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
@@ -125,23 +191,81 @@ void Node::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
         setText(text);
 }
 
+// The base class moves every selected node; their links are brought up to
+// date before the scene handles the repaints that the moves have queued.
+void Node::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    QGraphicsItem::mouseMoveEvent(event);
+    Link::trackPendingLinks();
+}
+
 QVariant Node::itemChange(GraphicsItemChange change,
                           const QVariant &value)
 {
-    foreach (Link *link, myLinks)
-        link->trackNodes();
+    if (change == ItemPositionHasChanged) {
+        myChanges |= Moved;
+        for (Link *link: myLinks)
+            link->trackLater();
+    }
     return QGraphicsItem::itemChange(change, value);
 }
 
 QRectF Node::outlineRect() const
+{
+    return myOutlineRect;
+}
+
+// Measures the text once per change instead of on every paint and hit
+// test; outlineRect() and shape() return the cached results.
+void Node::updateOutline()
 {
     const int Padding = 8;
-    //QFontMetricsF metrics = qApp->font();
     QFontMetricsF metrics(qApp->font());
     QRectF rect = metrics.boundingRect(myText);
     rect.adjust(-Padding, -Padding, +Padding, +Padding);
     rect.translate(-rect.center());
-    return rect;
+    myOutlineRect = rect;
+
+    myShape = QPainterPath();
+    myShape.addRoundRect(rect, roundness(rect.width()),
+                         roundness(rect.height()));
+}
+
+// Labels are drawn at levels of detail (view scales) from textLevel up,
+// rounded outlines from outlineLevel, plain rectangles from rectLevel, and
+// below that each node is a single point. Links follow the same tiers.
+void Node::setDetailThresholds(qreal textLevel, qreal outlineLevel,
+                               qreal rectLevel)
+{
+    textDetailLevel = textLevel;
+    outlineDetailLevel = outlineLevel;
+    rectDetailLevel = rectLevel;
+}
+
+Node::Detail Node::detailFor(qreal levelOfDetail)
+{
+    if (levelOfDetail >= textDetailLevel)
+        return FullDetail;
+    if (levelOfDetail >= outlineDetailLevel)
+        return OutlineDetail;
+    if (levelOfDetail >= rectDetailLevel)
+        return RectDetail;
+    return PointDetail;
+}
+
+// Nodes created after this call are rendered once into a pixmap in device
+// coordinates and redrawn from it until they change. Every setter, and Qt
+// itself on selection changes, calls update(), which discards the pixmap.
+void Node::setPixmapCaching(bool enabled)
+{
+    pixmapCaching = enabled;
+}
+
+// The pixmaps are kept in QPixmapCache, which evicts the least recently
+// used ones beyond this budget.
+void Node::setPixmapCacheBudget(int kilobytes)
+{
+    QPixmapCache::setCacheLimit(kilobytes);
 }
 
 int Node::roundness(double size) const
@@ -196,3 +320,41 @@ Node *Node::newFromJson(json11::Json json)
 
     return node;
 }
+
+Node *Node::newFromRecord(const NodeRecord &record)
+{
+    auto node = new Node(record.index);
+    node->setText(QString(record.text.c_str()));
+    node->setPos(record.x, record.y);
+    if (record.hasColors) {
+        node->setTextColor(QColor::fromRgba(record.textColor));
+        node->setOutlineColor(QColor::fromRgba(record.outlineColor));
+        node->setBackgroundColor(QColor::fromRgba(record.backgroundColor));
+    }
+    node->clearChanges();
+
+    return node;
+}
+
+// Gives a record read without colors those of a new node.
+void Node::setDefaultColors(NodeRecord &record)
+{
+    record.hasColors = true;
+    record.textColor = QColor(DEFAULT_TEXT_COLOR).rgba();
+    record.outlineColor = QColor(DEFAULT_OUTLINE_COLOR).rgba();
+    record.backgroundColor = QColor(DEFAULT_BACKGROUND_COLOR).rgba();
+}
+
+NodeRecord Node::toRecord() const
+{
+    NodeRecord record;
+    record.index = myIndex;
+    record.text = myText.toStdString();
+    record.x = (int) x();
+    record.y = (int) y();
+    record.hasColors = true;
+    record.textColor = myTextColor.rgba();
+    record.outlineColor = myOutlineColor.rgba();
+    record.backgroundColor = myBackgroundColor.rgba();
+    return record;
+}
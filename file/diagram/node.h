@@ -4,8 +4,11 @@
 #include <QApplication>
 #include <QColor>
 #include <QGraphicsItem>
-#include <QSet>
+#include <QPainterPath>
+#include "diagramrecord.h"
 #include "json11.hpp"
+#include "slotmap.h"
+#include "smallvector.h"
 
 class Link;
 
@@ -14,6 +17,14 @@ class Node : public QGraphicsItem
     Q_DECLARE_TR_FUNCTIONS(Node)
 
 public:
+    // How much of a node is drawn at a given view scale; see
+    // setDetailThresholds().
+    enum Detail { PointDetail, RectDetail, OutlineDetail, FullDetail };
+
+    // Edits made to a node since its item was created from a record or
+    // since clearChanges(); see changes().
+    enum Change { Moved = 0x1, Renamed = 0x2, Recolored = 0x4 };
+
     Node(int index);
     ~Node();
 
@@ -26,33 +37,55 @@ public:
     QColor outlineColor() const;
     void setBackgroundColor(const QColor &color);
     QColor backgroundColor() const;
+    void fontChanged();
+    int changes() const;
+    void clearChanges();
 
     void addLink(Link *link);
     void removeLink(Link *link);
+    const SmallVector<Link *, 4> &links() const;
+
+    SlotHandle handle() const;
+    void setHandle(SlotHandle handle);
 
     QRectF boundingRect() const;
     QPainterPath shape() const;
     void paint(QPainter *painter,
                const QStyleOptionGraphicsItem *option, QWidget *widget);
 
+    static void setDetailThresholds(qreal textLevel, qreal outlineLevel,
+                                    qreal rectLevel);
+    static Detail detailFor(qreal levelOfDetail);
+    static void setPixmapCaching(bool enabled);
+    static void setPixmapCacheBudget(int kilobytes);
+
     static Node *newFromJson(json11::Json json);
+    static Node *newFromRecord(const NodeRecord &record);
+    static void setDefaultColors(NodeRecord &record);
+    NodeRecord toRecord() const;
     json11::Json toJson();
 
 protected:
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event);
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
     QVariant itemChange(GraphicsItemChange change,
                         const QVariant &value);
 
 private:
     QRectF outlineRect() const;
+    void updateOutline();
     int roundness(double size) const;
 
-    QSet<Link *> myLinks;
+    SmallVector<Link *, 4> myLinks;
     QString myText;
     QColor myTextColor;
     QColor myBackgroundColor;
     QColor myOutlineColor;
+    QRectF myOutlineRect;
+    QPainterPath myShape;
     int myIndex;
+    int myChanges;
+    SlotHandle myHandle;
 };
 
 #endif
@@ -0,0 +1,131 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Refers to a value in a SlotMap. A handle whose value has been erased is
+// stale: its generation no longer matches, and lookups find nothing.
+struct SlotHandle
+{
+    uint32_t slot;
+    uint32_t generation;
+
+    SlotHandle() : slot(0), generation(0) {}
+    SlotHandle(uint32_t slot, uint32_t generation)
+        : slot(slot), generation(generation) {}
+
+    bool isNull() const { return generation == 0; }
+};
+
+// A generational slot map. Values are stored contiguously and iterated in
+// that order; erasing a value moves the last one into its place. Insert,
+// erase and lookup by handle take constant time, and erased slots are
+// reused under a new generation.
+template <typename T>
+class SlotMap
+{
+public:
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    SlotMap() : myFreeSlot(NO_SLOT) {}
+
+    SlotHandle insert(const T &value)
+    {
+        uint32_t slot;
+        if (myFreeSlot != NO_SLOT) {
+            slot = myFreeSlot;
+            myFreeSlot = mySlots[slot].position;
+        } else {
+            slot = mySlots.size();
+            mySlots.push_back(Slot());
+        }
+
+        mySlots[slot].position = myValues.size();
+        myValues.push_back(value);
+        mySlotOfValue.push_back(slot);
+        return SlotHandle(slot, mySlots[slot].generation);
+    }
+
+    bool erase(SlotHandle handle)
+    {
+        if (!contains(handle))
+            return false;
+
+        Slot &slot = mySlots[handle.slot];
+        uint32_t last = myValues.size() - 1;
+        if (slot.position != last) {
+            myValues[slot.position] = myValues[last];
+            mySlotOfValue[slot.position] = mySlotOfValue[last];
+            mySlots[mySlotOfValue[last]].position = slot.position;
+        }
+        myValues.pop_back();
+        mySlotOfValue.pop_back();
+
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        slot.position = myFreeSlot;
+        myFreeSlot = handle.slot;
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const
+    {
+        return handle.slot < mySlots.size() && !handle.isNull()
+               && mySlots[handle.slot].generation == handle.generation;
+    }
+
+    const T *find(SlotHandle handle) const
+    {
+        if (!contains(handle))
+            return 0;
+        return &myValues[mySlots[handle.slot].position];
+    }
+
+    size_t size() const { return myValues.size(); }
+    bool empty() const { return myValues.empty(); }
+    const_iterator begin() const { return myValues.begin(); }
+    const_iterator end() const { return myValues.end(); }
+
+    void reserve(size_t size)
+    {
+        myValues.reserve(size);
+        mySlotOfValue.reserve(size);
+        mySlots.reserve(size);
+    }
+
+    // Handles given out before clear() stay stale, as generations are kept.
+    void clear()
+    {
+        myValues.clear();
+        mySlotOfValue.clear();
+        myFreeSlot = NO_SLOT;
+        for (uint32_t i = mySlots.size(); i-- > 0; ) {
+            if (++mySlots[i].generation == 0)
+                mySlots[i].generation = 1;
+            mySlots[i].position = myFreeSlot;
+            myFreeSlot = i;
+        }
+    }
+
+private:
+    static const uint32_t NO_SLOT = 0xffffffffu;
+
+    // A used slot holds the position of its value; a free slot holds the
+    // next free slot.
+    struct Slot
+    {
+        uint32_t position;
+        uint32_t generation;
+
+        Slot() : position(0), generation(1) {}
+    };
+
+    std::vector<T> myValues;
+    std::vector<uint32_t> mySlotOfValue;
+    std::vector<Slot> mySlots;
+    uint32_t myFreeSlot;
+};
+
+#endif
@@ -0,0 +1,10 @@
+# Checks that JsonDocument parses as Json::parse does, across reuse of its
+# arena, and that a reused document allocates less than Json::parse.
+
+TEMPLATE = app
+TARGET = tst_json11document
+CONFIG += console c++17 testcase
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+SOURCES += tst_json11document.cpp ../../json11.cpp
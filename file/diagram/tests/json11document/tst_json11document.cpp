@@ -0,0 +1,140 @@
+// A JsonDocument has to give the values Json::parse gives, for documents
+// smaller and larger than its arena's blocks, in any order on the same
+// document, and after a failed parse. Reusing it for journal-sized lines
+// has to allocate less than Json::parse does. Allocations are counted by
+// replacing the global operator new.
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "json11.hpp"
+
+using json11::Json;
+using json11::JsonDocument;
+
+namespace {
+long allocations = 0;
+int failures = 0;
+
+void fail(const char *what, size_t i)
+{
+    if (++failures <= 20)
+        std::printf("FAIL %s: document %zu\n", what, i);
+}
+
+// A journal line as DiagramJournal writes it.
+std::string journalLine(int index)
+{
+    return "{\"backgroundColor\": \"#ffffffff\", \"index\": "
+           + std::to_string(index)
+           + ", \"op\": \"addNode\", \"outlineColor\": \"#ff00008b\", "
+             "\"text\": \"a label longer than the small string buffer\", "
+             "\"textColor\": \"#ff006400\", \"x\": 100, \"y\": -200}\n";
+}
+
+// An array of count node objects, which needs several arena blocks.
+std::string nodeArray(int count)
+{
+    std::string text = "[";
+    for (int i = 0; i < count; ++i) {
+        text += i ? ", " : "";
+        text += "{\"index\": " + std::to_string(i) + ", \"text\": \"Node "
+                + std::to_string(i) + "\", \"x\": " + std::to_string(i * 0.5)
+                + ", \"y\": [true, false, null, {}, []]}";
+    }
+    text += "]";
+    return text;
+}
+
+std::vector<std::string> documents()
+{
+    std::vector<std::string> list;
+    list.push_back("0");
+    list.push_back("\"\"");
+    list.push_back("[]");
+    list.push_back("{\"a\": [1, 2.5, \"x\", {\"k\": true, \"n\": null}], "
+                   "\"b\": \"\\u00e9\\n\"}");
+    list.push_back(journalLine(1));
+    list.push_back(nodeArray(20000));
+    list.push_back(journalLine(2));
+    list.push_back(nodeArray(10));
+    std::string deep;
+    for (int i = 0; i < 100; ++i)
+        deep += "[{\"k\": ";
+    deep += "1";
+    for (int i = 0; i < 100; ++i)
+        deep += "}]";
+    list.push_back(deep);
+    return list;
+}
+}
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    void *memory = std::malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main()
+{
+    std::vector<std::string> list = documents();
+    JsonDocument document;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < list.size(); ++i) {
+            std::string err;
+            Json expected = Json::parse(list[i], err);
+            if (!err.empty()) {
+                fail("Json::parse", i);
+                continue;
+            }
+            if (!document.parse(list[i].data(), list[i].size(), err)
+                    || !err.empty())
+                fail("JsonDocument::parse", i);
+            else if (document.root() != expected
+                     || document.root().dump() != expected.dump())
+                fail("values differ", i);
+
+            std::string bad = list[i] + " ]";
+            if (document.parse(bad.data(), bad.size(), err) || err.empty()
+                    || !document.root().is_null())
+                fail("trailing garbage accepted", i);
+        }
+    }
+
+    std::string line = journalLine(3);
+    std::string err;
+    document.parse(line.data(), line.size(), err);
+    long before = allocations;
+    Json parsed = Json::parse(line, err);
+    long heap = allocations - before;
+    before = allocations;
+    document.parse(line.data(), line.size(), err);
+    long arena = allocations - before;
+    if (arena >= heap) {
+        std::printf("FAIL reused document: %ld allocations, Json::parse %ld\n",
+                    arena, heap);
+        ++failures;
+    }
+
+    if (failures) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("JsonDocument agrees with Json::parse; a journal line takes "
+                "%ld allocations instead of %ld\n", arena, heap);
+    return 0;
+}
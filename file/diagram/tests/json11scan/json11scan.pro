@@ -0,0 +1,10 @@
+# Checks json11's vector scanners against the scalar ones. The test compiles
+# json11.cpp itself to reach the scanners, which are internal to it.
+
+TEMPLATE = app
+TARGET = tst_json11scan
+CONFIG += console c++17 testcase
+CONFIG -= qt app_bundle
+INCLUDEPATH += ../..
+
+SOURCES += tst_json11scan.cpp
@@ -0,0 +1,143 @@
+// Every vector scanner has to return what the scalar one returns: at both
+// ends of a 16- and 32-byte block, on tails shorter than a block, at any
+// alignment, and with the byte that ends a run anywhere in the input. The
+// input is allocated to its exact size, so that a sanitizer build also
+// catches reads past its end.
+#include "../../json11.cpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace json11;
+
+namespace {
+typedef size_t (*Scanner)(const char *p, size_t n);
+
+struct Candidate
+{
+    const char *name;
+    Scanner whitespace;
+    Scanner string;
+};
+
+const size_t MAX_LENGTH = 100;
+const size_t MAX_OFFSET = 32;
+
+// Bytes that end a run of string characters, and some that must not.
+const unsigned char STRING_STOPS[] = { '"', '\\', 0x00, 0x01, '\n', 0x1f };
+const unsigned char STRING_PLAIN[] = { 'a', ' ', 0x20, 0x7f, 0x80, 0xc3,
+                                       0xff, '/' };
+const unsigned char SPACE_STOPS[] = { 'a', '"', 0x00, 0x0b, 0x0c, 0x80,
+                                      0xff };
+const unsigned char SPACE_PLAIN[] = { ' ', '\t', '\n', '\r' };
+
+int failures = 0;
+
+std::vector<Candidate> candidates()
+{
+    std::vector<Candidate> list;
+#ifdef JSON11_X86_SCAN
+    list.push_back({ "sse2", scan_whitespace_sse2, scan_string_sse2 });
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        list.push_back({ "avx2", scan_whitespace_avx2, scan_string_avx2 });
+    else
+        std::printf("avx2 not supported here, not tested\n");
+#endif
+    return list;
+}
+
+void check(const Candidate &candidate, bool isString, Scanner scanner,
+           Scanner reference, const std::vector<char> &buffer, size_t offset)
+{
+    const char *p = buffer.data() + offset;
+    size_t n = buffer.size() - offset;
+    size_t expected = reference(p, n);
+    size_t actual = scanner(p, n);
+    if (actual != expected) {
+        if (++failures <= 20)
+            std::printf("FAIL %s %s: length %zu offset %zu: %zu, expected %zu\n",
+                        candidate.name, isString ? "string" : "whitespace",
+                        n, offset, actual, expected);
+    }
+}
+
+// Runs of every plain byte, with at most one stop byte placed anywhere.
+void checkScanner(const Candidate &candidate, bool isString)
+{
+    Scanner scanner = isString ? candidate.string : candidate.whitespace;
+    Scanner reference = isString ? scan_string_scalar
+                                 : scan_whitespace_scalar;
+    const unsigned char *plain = isString ? STRING_PLAIN : SPACE_PLAIN;
+    size_t plainCount = isString ? sizeof(STRING_PLAIN) : sizeof(SPACE_PLAIN);
+    const unsigned char *stops = isString ? STRING_STOPS : SPACE_STOPS;
+    size_t stopCount = isString ? sizeof(STRING_STOPS) : sizeof(SPACE_STOPS);
+
+    for (size_t offset = 0; offset < MAX_OFFSET; ++offset) {
+        for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+            std::vector<char> buffer(offset + length);
+            for (size_t i = 0; i < buffer.size(); ++i)
+                buffer[i] = char(plain[i % plainCount]);
+            check(candidate, isString, scanner, reference, buffer, offset);
+
+            for (size_t at = 0; at < length; ++at) {
+                for (size_t s = 0; s < stopCount; ++s) {
+                    char saved = buffer[offset + at];
+                    buffer[offset + at] = char(stops[s]);
+                    check(candidate, isString, scanner, reference, buffer,
+                          offset);
+                    buffer[offset + at] = saved;
+                }
+            }
+        }
+    }
+}
+
+// Strings whose escape or control character sits around a block boundary
+// parse the same as through the scalar path, which this build checks
+// against a value built by hand.
+void checkParse()
+{
+    for (size_t before = 0; before < 70; ++before) {
+        for (size_t after = 0; after < 40; ++after) {
+            std::string body(before, 'x');
+            std::string value = body + "\"\\\n";
+            body += "\\\"\\\\\\n";
+            body.append(after, 'y');
+            value.append(after, 'y');
+
+            std::string err;
+            Json json = Json::parse("\"" + body + "\"", err);
+            if (!err.empty() || json.string_value() != value) {
+                if (++failures <= 20)
+                    std::printf("FAIL parse escape at %zu of %zu: %s\n",
+                                before, before + 6 + after, err.c_str());
+            }
+
+            std::string control(before, 'x');
+            control += '\x01';
+            control.append(after, 'y');
+            Json::parse("\"" + control + "\"", err);
+            if (err.empty() && ++failures <= 20)
+                std::printf("FAIL control character at %zu accepted\n",
+                            before);
+        }
+    }
+}
+}
+
+int main()
+{
+    for (const auto &candidate: candidates()) {
+        checkScanner(candidate, false);
+        checkScanner(candidate, true);
+    }
+    checkParse();
+
+    if (failures) {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+    std::printf("all scanners agree\n");
+    return 0;
+}
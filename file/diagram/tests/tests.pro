@@ -0,0 +1,4 @@
+# Self-checking tests; "make check" builds and runs them.
+
+TEMPLATE = subdirs
+SUBDIRS += json11document json11scan
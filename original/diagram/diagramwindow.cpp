@@ -32,6 +32,18 @@ DiagramWindow::DiagramWindow()
     updateActions();
 }
 
+void DiagramWindow::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange) {
+        foreach (QGraphicsItem *item, scene->items()) {
+            Node *node = dynamic_cast<Node *>(item);
+            if (node)
+                node->fontChanged();
+        }
+    }
+    QMainWindow::changeEvent(event);
+}
+
 void DiagramWindow::addNode()
 {
     Node *node = new Node;
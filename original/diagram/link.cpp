@@ -1,12 +1,19 @@
 #include <QtWidgets>
+#include <vector>
 
 #include "link.h"
 #include "node.h"
 
+namespace {
+// Links waiting for trackPendingLinks().
+std::vector<Link *> pendingLinks;
+}
+
 Link::Link(Node *fromNode, Node *toNode)
 {
     myFromNode = fromNode;
     myToNode = toNode;
+    myPendingIndex = -1;
 
     myFromNode->addLink(this);
     myToNode->addLink(this);
@@ -20,6 +27,12 @@ Link::Link(Node *fromNode, Node *toNode)
 
 Link::~Link()
 {
+    if (myPendingIndex >= 0) {
+        Link *last = pendingLinks.back();
+        pendingLinks[myPendingIndex] = last;
+        last->myPendingIndex = myPendingIndex;
+        pendingLinks.pop_back();
+    }
     myFromNode->removeLink(this);
     myToNode->removeLink(this);
 }
@@ -48,3 +61,37 @@ void Link::trackNodes()
 {
     setLine(QLineF(myFromNode->pos(), myToNode->pos()));
 }
+
+// Defers trackNodes() to the next trackPendingLinks(). A link whose nodes
+// move many times in between, or which is marked by both of its nodes, is
+// updated once. Node::mouseMoveEvent() flushes at the end of each drag
+// step; the timer covers moves made in code.
+void Link::trackLater()
+{
+    if (myPendingIndex >= 0)
+        return;
+
+    if (pendingLinks.empty())
+        QTimer::singleShot(0, &Link::trackPendingLinks);
+    myPendingIndex = pendingLinks.size();
+    pendingLinks.push_back(this);
+}
+
+void Link::trackPendingLinks()
+{
+    std::vector<Link *> links;
+    links.swap(pendingLinks);
+    for (Link *link: links) {
+        link->myPendingIndex = -1;
+        link->trackNodes();
+    }
+}
+
+void Link::paint(QPainter *painter,
+                 const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (Node::detailFor(option->levelOfDetailFromTransform(
+                            painter->worldTransform())) == Node::PointDetail)
+        painter->setRenderHint(QPainter::Antialiasing, false);
+    QGraphicsLineItem::paint(painter, option, widget);
+}
@@ -18,10 +18,16 @@ public:
     QColor color() const;
 
     void trackNodes();
+    void trackLater();
+    static void trackPendingLinks();
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option, QWidget *widget);
 
 private:
     Node *myFromNode;
     Node *myToNode;
+    int myPendingIndex;
 };
 
 #endif
@@ -0,0 +1,97 @@
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// A vector of trivially copyable values that keeps up to N of them inside
+// the object itself and moves to the heap only when it outgrows that. The
+// values are contiguous either way. removeOne() does not keep the order of
+// the remaining values.
+template <typename T, int N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallVector copies its values as plain memory");
+
+public:
+    typedef const T *const_iterator;
+
+    SmallVector() : mySize(0), myCapacity(N) {}
+
+    SmallVector(const SmallVector &other) : mySize(0), myCapacity(N)
+    {
+        *this = other;
+    }
+
+    ~SmallVector()
+    {
+        if (isHeap())
+            delete [] myHeap;
+    }
+
+    SmallVector &operator=(const SmallVector &other)
+    {
+        if (this != &other) {
+            mySize = 0;
+            reserve(other.mySize);
+            std::copy(other.begin(), other.end(), data());
+            mySize = other.mySize;
+        }
+        return *this;
+    }
+
+    void append(const T &value)
+    {
+        if (mySize == myCapacity)
+            reserve(2 * myCapacity);
+        data()[mySize++] = value;
+    }
+
+    // Searches from the back, where the most recently appended values are.
+    bool removeOne(const T &value)
+    {
+        T *values = data();
+        for (uint32_t i = mySize; i-- > 0; ) {
+            if (values[i] == value) {
+                values[i] = values[--mySize];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isEmpty() const { return mySize == 0; }
+    int size() const { return mySize; }
+    const T &last() const { return data()[mySize - 1]; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + mySize; }
+
+private:
+    bool isHeap() const { return myCapacity > uint32_t(N); }
+    T *data() { return isHeap() ? myHeap : myInline; }
+    const T *data() const { return isHeap() ? myHeap : myInline; }
+
+    void reserve(uint32_t capacity)
+    {
+        if (capacity <= myCapacity)
+            return;
+
+        T *values = new T[capacity];
+        std::copy(begin(), end(), values);
+        if (isHeap())
+            delete [] myHeap;
+        myHeap = values;
+        myCapacity = capacity;
+    }
+
+    uint32_t mySize;
+    uint32_t myCapacity;
+    union {
+        T myInline[N];
+        T *myHeap;
+    };
+};
+
+#endif